@@ -0,0 +1,532 @@
+//
+// Time the step1 hit selection of EcalPhiSymHitBatch, select() then
+// accumulate(), against the per-hit loop it replaced, over the same
+// synthetic events: hashed indices drawn without repetition, in
+// increasing order as in the rechit collections, and exponential
+// energies. The crystal table is synthetic too, with the eta of the
+// barrel rings and of 39 endcap rings and one crystal in 97 bad.
+//
+// select() runs the AVX2 kernel when the CPU has it; the batch loop is
+// then timed a second time with the scalar kernel. All loops must give
+// the same sums, which is checked after timing.
+//
+// The same events then go through the six accumulateHits<Reiterate,
+// KScan, Spectra> specializations of EcalPhiSymStep1Algo, one job
+// configuration each, and through the generic loop they replaced, which
+// tests the modes for every hit. The full step1 sums must agree.
+//
+// usage: phisymBatchBench [options]
+//
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitBatch.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConstants.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Algo.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Sums.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace {
+
+  void usage(const char* prog){
+    std::cerr << "usage: " << prog << " [options]\n"
+	      << "  -n events        synthetic events (1000)\n"
+	      << "  -b hits          barrel hits per event (4000)\n"
+	      << "  -e hits          endcap hits per event (1500)\n"
+	      << "  -r repeats       passes over the events, best one reported (5)\n"
+	      << "  -c               previous constants around 1, as when reiterating\n"
+	      << "  -f               ET sums as integer keV\n"
+	      << "  -s seed          random seed (1)\n";
+  }
+
+  /// hits of one event, barrel then endcap
+  struct Event {
+    std::vector<int>   hi_barl;
+    std::vector<float> e_barl;
+    std::vector<int>   hi_endc;
+    std::vector<float> e_endc;
+  };
+
+  void makeTable(EcalPhiSymCrystalTable& crystals){
+
+    const int nBarl = EBDetId::kSizeForDenseIndexing;
+    crystals.eta_barl_    .assign(nBarl, 0.);
+    crystals.invCosh_barl_.assign(nBarl, 0.);
+    crystals.eCut_barl_   .assign(nBarl, 0.);
+    crystals.etThr_barl_  .assign(nBarl, 0.);
+    crystals.ring_barl_   .assign(nBarl, 0);
+    crystals.sign_barl_   .assign(nBarl, 0);
+    crystals.good_barl_   .assign(nBarl, 0);
+    crystals.sel_barl_    .assign(nBarl, 0);
+    for (int hi=0; hi<nBarl; hi++) {
+      EBDetId eb = EBDetId::unhashIndex(hi);
+      float eta = (abs(eb.ieta())-0.5)*0.0174;
+      crystals.eta_barl_[hi]     = eta;
+      crystals.invCosh_barl_[hi] = 1./cosh(eta);
+      crystals.ring_barl_[hi]    = abs(eb.ieta())-1;
+      crystals.sign_barl_[hi]    = eb.zside()>0 ? 1 : 0;
+      crystals.good_barl_[hi]    = hi%97!=0;
+      crystals.sel_barl_[hi]     = 1;
+    }
+
+    const int nEndc = EEDetId::kSizeForDenseIndexing;
+    crystals.eta_endc_    .assign(nEndc, 0.);
+    crystals.invCosh_endc_.assign(nEndc, 0.);
+    crystals.eCut_endc_   .assign(nEndc, 0.);
+    crystals.etThr_endc_  .assign(nEndc, 0.);
+    crystals.ring_endc_   .assign(nEndc, -1);
+    crystals.sign_endc_   .assign(nEndc, 0);
+    crystals.good_endc_   .assign(nEndc, 0);
+    crystals.sel_endc_    .assign(nEndc, 0);
+    crystals.etaRing_.assign(kEndcEtaRings, 0.);
+    for (int ring=0; ring<kEndcEtaRings; ring++)
+      crystals.etaRing_[ring] = 1.49 + ring*0.038;
+    for (int hi=0; hi<nEndc; hi++) {
+      int ring = (hi/17)%kEndcEtaRings;
+      float eta = crystals.etaRing_[ring];
+      crystals.eta_endc_[hi]     = eta;
+      crystals.invCosh_endc_[hi] = 1./cosh(eta);
+      crystals.ring_endc_[hi]    = ring;
+      crystals.sign_endc_[hi]    = hi>=nEndc/2 ? 1 : 0;
+      crystals.good_endc_[hi]    = hi%97!=0;
+      crystals.sel_endc_[hi]     = 1;
+    }
+
+    crystals.setCuts(0.55, -0.150, 0.600);
+  }
+
+  void makeHits(std::mt19937& rng, int ncells, int nhits, float meanE,
+		std::vector<int>& hi, std::vector<float>& e){
+
+    std::vector<int> cells(ncells);
+    for (int i=0; i<ncells; i++) cells[i]=i;
+    nhits = std::min(nhits, ncells);
+    for (int i=0; i<nhits; i++)
+      std::swap(cells[i], cells[i+rng()%(ncells-i)]);
+    hi.assign(cells.begin(), cells.begin()+nhits);
+    std::sort(hi.begin(), hi.end());
+
+    std::exponential_distribution<float> energy(1./meanE);
+    e.resize(nhits);
+    for (int i=0; i<nhits; i++) e[i] = energy(rng);
+  }
+
+  void addBatch(EcalPhiSymHitBatch& batch, const float* invCosh, const float* eCut,
+		const float* etThr, const int* sel, double* etsum,
+		long long* etsumKeV, unsigned int* nhits, unsigned int& overflows){
+    batch.select(invCosh, eCut, etThr, sel);
+    if (etsumKeV) batch.accumulate(etsumKeV, nhits, overflows);
+    else          batch.accumulate(etsum, nhits);
+    batch.clear();
+  }
+
+  /// select() and accumulate(), batches filled per event as in step1
+  void batchLoop(const std::vector<Event>& events, const EcalPhiSymCrystalTable& c,
+		 const std::vector<float>* calibs, EcalPhiSymAccumulator& acc){
+
+    bool fixed = acc.fixedPoint();
+    EcalPhiSymHitBatch batch;
+    for (size_t iev=0; iev<events.size(); iev++) {
+      const Event& ev = events[iev];
+      for (size_t i=0; i<ev.hi_barl.size(); i++) {
+	int hi = ev.hi_barl[i];
+	batch.push(hi, ev.e_barl[i], calibs ? calibs[0][hi] : 1.f);
+	if (batch.full())
+	  addBatch(batch, &c.invCosh_barl_[0], &c.eCut_barl_[0], &c.etThr_barl_[0],
+		   &c.sel_barl_[0], &acc.etsum_barl_[0],
+		   fixed ? &acc.etsumKeV_barl_[0] : 0, &acc.nhits_barl_[0], acc.overflows_);
+      }
+      if (batch.n)
+	addBatch(batch, &c.invCosh_barl_[0], &c.eCut_barl_[0], &c.etThr_barl_[0],
+		 &c.sel_barl_[0], &acc.etsum_barl_[0],
+		 fixed ? &acc.etsumKeV_barl_[0] : 0, &acc.nhits_barl_[0], acc.overflows_);
+
+      for (size_t i=0; i<ev.hi_endc.size(); i++) {
+	int hi = ev.hi_endc[i];
+	batch.push(hi, ev.e_endc[i], calibs ? calibs[1][hi] : 1.f);
+	if (batch.full())
+	  addBatch(batch, &c.invCosh_endc_[0], &c.eCut_endc_[0], &c.etThr_endc_[0],
+		   &c.sel_endc_[0], &acc.etsum_endc_[0],
+		   fixed ? &acc.etsumKeV_endc_[0] : 0, &acc.nhits_endc_[0], acc.overflows_);
+      }
+      if (batch.n)
+	addBatch(batch, &c.invCosh_endc_[0], &c.eCut_endc_[0], &c.etThr_endc_[0],
+		 &c.sel_endc_[0], &acc.etsum_endc_[0],
+		 fixed ? &acc.etsumKeV_endc_[0] : 0, &acc.nhits_endc_[0], acc.overflows_);
+    }
+  }
+
+  /// one hit at a time, the same products and cuts
+  void scalarLoop(const std::vector<Event>& events, const EcalPhiSymCrystalTable& c,
+		  const std::vector<float>* calibs, EcalPhiSymAccumulator& acc){
+
+    bool fixed = acc.fixedPoint();
+    for (size_t iev=0; iev<events.size(); iev++) {
+      const Event& ev = events[iev];
+      for (size_t i=0; i<ev.hi_barl.size(); i++) {
+	int hi = ev.hi_barl[i];
+	float scale = calibs ? calibs[0][hi] : 1.f;
+	float et = ev.e_barl[i]*c.invCosh_barl_[hi]*scale;
+	float e  = ev.e_barl[i]*scale;
+	if (!(e > c.eCut_barl_[hi] && et < c.etThr_barl_[hi] && c.sel_barl_[hi])) continue;
+	if (fixed) {
+	  if (!EcalPhiSymAccumulator::addKeV(acc.etsumKeV_barl_[hi],
+					     EcalPhiSymAccumulator::toKeV(et)))
+	    acc.overflows_++;
+	} else
+	  acc.etsum_barl_[hi] += et;
+	acc.nhits_barl_[hi]++;
+      }
+      for (size_t i=0; i<ev.hi_endc.size(); i++) {
+	int hi = ev.hi_endc[i];
+	float scale = calibs ? calibs[1][hi] : 1.f;
+	float et = ev.e_endc[i]*c.invCosh_endc_[hi]*scale;
+	float e  = ev.e_endc[i]*scale;
+	if (!(e > c.eCut_endc_[hi] && et < c.etThr_endc_[hi] && c.sel_endc_[hi])) continue;
+	if (fixed) {
+	  if (!EcalPhiSymAccumulator::addKeV(acc.etsumKeV_endc_[hi],
+					     EcalPhiSymAccumulator::toKeV(et)))
+	    acc.overflows_++;
+	} else
+	  acc.etsum_endc_[hi] += et;
+	acc.nhits_endc_[hi]++;
+      }
+    }
+  }
+
+  bool sameSums(const EcalPhiSymAccumulator& a, const EcalPhiSymAccumulator& b){
+    return a.etsum_barl_==b.etsum_barl_ && a.nhits_barl_==b.nhits_barl_ &&
+      a.etsum_endc_==b.etsum_endc_ && a.nhits_endc_==b.nhits_endc_ &&
+      a.etsumKeV_barl_==b.etsumKeV_barl_ && a.etsumKeV_endc_==b.etsumKeV_endc_;
+  }
+
+  typedef void (*Loop)(const std::vector<Event>&, const EcalPhiSymCrystalTable&,
+		       const std::vector<float>*, EcalPhiSymAccumulator&);
+
+  /// the step1 hit loop with the job modes tested per hit, as before
+  /// accumulateHits was specialized on them; same sums otherwise
+  struct Modes {
+    bool reiterate;
+    bool kscan;
+    bool spectra;
+    double miscalEB[EcalPhiSymStep1Algo::kNMiscalBinsEB];
+    double miscalEE[EcalPhiSymStep1Algo::kNMiscalBinsEE];
+  };
+
+  void addBarl(const EcalPhiSymHitBatch& batch, EcalPhiSymAccumulator& acc, int& selected){
+    if (acc.fixedPoint()) {
+      batch.accumulateMoments(&acc.esumKeV_barl_[0], &acc.et2sumKeV_barl_[0],
+			      &acc.e2sumKeV_barl_[0], acc.overflows_);
+      selected = batch.accumulate(&acc.etsumKeV_barl_[0], &acc.nhits_barl_[0], acc.overflows_);
+    } else {
+      batch.accumulateMoments(&acc.esum_barl_[0], &acc.et2sum_barl_[0], &acc.e2sum_barl_[0]);
+      selected = batch.accumulate(&acc.etsum_barl_[0], &acc.nhits_barl_[0]);
+    }
+  }
+
+  void addEndc(const EcalPhiSymHitBatch& batch, EcalPhiSymAccumulator& acc, int& selected){
+    if (acc.fixedPoint()) {
+      batch.accumulateMoments(&acc.esumKeV_endc_[0], &acc.et2sumKeV_endc_[0],
+			      &acc.e2sumKeV_endc_[0], acc.overflows_);
+      selected = batch.accumulate(&acc.etsumKeV_endc_[0], &acc.nhits_endc_[0], acc.overflows_);
+    } else {
+      batch.accumulateMoments(&acc.esum_endc_[0], &acc.et2sum_endc_[0], &acc.e2sum_endc_[0]);
+      selected = batch.accumulate(&acc.etsum_endc_[0], &acc.nhits_endc_[0]);
+    }
+  }
+
+  bool genericHits(const EBRecHitCollection& barrelRecHits,
+		   const EERecHitCollection& endcapRecHits,
+		   const EcalPhiSymCrystalTable& c, const EcalPhiSymConstants& calibs,
+		   const Modes& modes, EcalPhiSymStep1Sums& sums){
+
+    EcalPhiSymAccumulator& acc = sums.sums_;
+    bool fixed = acc.fixedPoint();
+    bool pass=false;
+    EcalPhiSymHitBatch batch;
+
+    EBRecHitCollection::const_iterator itb=barrelRecHits.begin();
+    while (itb!=barrelRecHits.end()) {
+      batch.clear();
+      for (; itb!=barrelRecHits.end() && !batch.full(); itb++) {
+	int hi = EBDetId(itb->id()).hashedIndex();
+	batch.push(hi, itb->energy(), modes.reiterate ? calibs.barl_[hi] : 1.f);
+      }
+      batch.select(&c.invCosh_barl_[0], &c.eCut_barl_[0], &c.etThr_barl_[0], &c.sel_barl_[0]);
+      int selected;
+      addBarl(batch, acc, selected);
+      if (selected) pass=true;
+      sums.report_.hits_barl += batch.n;
+      sums.report_.selected_barl += selected;
+
+      for (int i=0; i<batch.n; i++) {
+	int hi = batch.hi[i];
+	int ieta = c.ring_barl_[hi];
+	int sign = c.sign_barl_[hi];
+	if (modes.kscan && c.good_barl_[hi]) {
+	  if (fixed)
+	    EcalPhiSymStep1Algo::fillMiscal(modes.miscalEB, EcalPhiSymStep1Algo::kNMiscalBinsEB,
+					    batch.e[i], batch.et[i], c.eCut_barl_[hi], c.etThr_barl_[hi],
+					    EcalPhiSymAccumulator::toKeV(batch.et[i]),
+					    sums.etdiffKeV_barl_miscal_[ieta][sign]);
+	  else
+	    EcalPhiSymStep1Algo::fillMiscal(modes.miscalEB, EcalPhiSymStep1Algo::kNMiscalBinsEB,
+					    batch.e[i], batch.et[i], c.eCut_barl_[hi], c.etThr_barl_[hi],
+					    double(batch.et[i]),
+					    sums.etdiff_barl_miscal_[ieta][sign]);
+	}
+	if (modes.kscan && modes.spectra)
+	  sums.spectra_.fillBarl(ieta, sign, batch.et[i], batch.e[i]);
+      }
+    }
+
+    EERecHitCollection::const_iterator ite=endcapRecHits.begin();
+    while (ite!=endcapRecHits.end()) {
+      batch.clear();
+      for (; ite!=endcapRecHits.end() && !batch.full(); ite++) {
+	int hi = EEDetId(ite->id()).hashedIndex();
+	batch.push(hi, ite->energy(), modes.reiterate ? calibs.endc_[hi] : 1.f);
+      }
+      batch.select(&c.invCosh_endc_[0], &c.eCut_endc_[0], &c.etThr_endc_[0], &c.sel_endc_[0]);
+      int selected;
+      addEndc(batch, acc, selected);
+      if (selected) pass=true;
+      sums.report_.hits_endc += batch.n;
+      sums.report_.selected_endc += selected;
+
+      for (int i=0; i<batch.n; i++) {
+	int hi = batch.hi[i];
+	int ring = c.ring_endc_[hi];
+	int sign = c.sign_endc_[hi];
+	if (modes.kscan && c.good_endc_[hi]) {
+	  if (fixed)
+	    EcalPhiSymStep1Algo::fillMiscal(modes.miscalEE, EcalPhiSymStep1Algo::kNMiscalBinsEE,
+					    batch.e[i], batch.et[i], c.eCut_endc_[hi], c.etThr_endc_[hi],
+					    EcalPhiSymAccumulator::toKeV(batch.et[i]),
+					    sums.etdiffKeV_endc_miscal_[ring][sign]);
+	  else
+	    EcalPhiSymStep1Algo::fillMiscal(modes.miscalEE, EcalPhiSymStep1Algo::kNMiscalBinsEE,
+					    batch.e[i], batch.et[i], c.eCut_endc_[hi], c.etThr_endc_[hi],
+					    double(batch.et[i]),
+					    sums.etdiff_endc_miscal_[ring][sign]);
+	}
+	if (modes.kscan && modes.spectra && ring!=-1)
+	  sums.spectra_.fillEndc(ring, sign, batch.et[i], batch.e[i]);
+      }
+    }
+
+    return pass;
+  }
+
+  std::string state(const EcalPhiSymStep1Sums& sums){
+    std::ostringstream out;
+    sums.writeState(out);
+    return out.str();
+  }
+
+  /// best time of the repeats, in seconds
+  double timeLoop(Loop loop, int repeats, const std::vector<Event>& events,
+		  const EcalPhiSymCrystalTable& crystals, const std::vector<float>* calibs,
+		  EcalPhiSymAccumulator& acc){
+
+    double best = 0.;
+    for (int irep=0; irep<repeats; irep++) {
+      acc.reset();
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      loop(events, crystals, calibs, acc);
+      double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      if (irep==0 || t<best) best = t;
+    }
+    return best;
+  }
+
+}
+
+
+int main(int argc, char** argv){
+
+  int nevents = 1000;
+  int nhitsBarl = 4000;
+  int nhitsEndc = 1500;
+  int repeats = 5;
+  bool reiterate = false;
+  bool fixedPoint = false;
+  unsigned int seed = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:b:e:r:cfs:h"))!=-1) {
+    switch (opt) {
+    case 'n': nevents = atoi(optarg); break;
+    case 'b': nhitsBarl = atoi(optarg); break;
+    case 'e': nhitsEndc = atoi(optarg); break;
+    case 'r': repeats = atoi(optarg); break;
+    case 'c': reiterate = true; break;
+    case 'f': fixedPoint = true; break;
+    case 's': seed = atoi(optarg); break;
+    default: usage(argv[0]); return 1;
+    }
+  }
+  if (nevents<1 || repeats<1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  EcalPhiSymCrystalTable crystals;
+  makeTable(crystals);
+
+  std::mt19937 rng(seed);
+  std::vector<Event> events(nevents);
+  unsigned long long nhits=0;
+  for (int iev=0; iev<nevents; iev++) {
+    makeHits(rng, EBDetId::kSizeForDenseIndexing, nhitsBarl, 0.4,
+	     events[iev].hi_barl, events[iev].e_barl);
+    makeHits(rng, EEDetId::kSizeForDenseIndexing, nhitsEndc, 1.5,
+	     events[iev].hi_endc, events[iev].e_endc);
+    nhits += events[iev].hi_barl.size() + events[iev].hi_endc.size();
+  }
+
+  std::vector<float> calibs[2];
+  if (reiterate) {
+    std::normal_distribution<float> calib(1., 0.02);
+    calibs[0].resize(EBDetId::kSizeForDenseIndexing);
+    calibs[1].resize(EEDetId::kSizeForDenseIndexing);
+    for (unsigned int i=0; i<calibs[0].size(); i++) calibs[0][i] = calib(rng);
+    for (unsigned int i=0; i<calibs[1].size(); i++) calibs[1][i] = calib(rng);
+  }
+
+  EcalPhiSymAccumulator batchSums, scalarSums;
+  batchSums.setFixedPoint(fixedPoint);
+  scalarSums.setFixedPoint(fixedPoint);
+
+  bool avx2 = EcalPhiSymHitBatch::avx2();
+  double tBatch  = timeLoop(batchLoop,  repeats, events, crystals,
+			    reiterate ? calibs : 0, batchSums);
+  double tScalar = timeLoop(scalarLoop, repeats, events, crystals,
+			    reiterate ? calibs : 0, scalarSums);
+
+  if (!sameSums(batchSums, scalarSums)) {
+    std::cerr << "Batch and per-hit sums differ" << std::endl;
+    return 1;
+  }
+
+  std::cout << nevents << " events, " << nhits << " hits, "
+	    << (fixedPoint ? "keV" : "double") << " sums"
+	    << (reiterate ? ", previous constants" : "") << std::endl;
+  std::cout << "batch (" << (avx2 ? "AVX2  " : "scalar") << " select)  "
+	    << nhits/tBatch  << " hits/s  speedup " << tScalar/tBatch << std::endl;
+
+  if (avx2) {
+    EcalPhiSymHitBatch::setAvx2(false);
+    double tBatchScalar = timeLoop(batchLoop, repeats, events, crystals,
+				   reiterate ? calibs : 0, batchSums);
+    EcalPhiSymHitBatch::setAvx2(true);
+    if (!sameSums(batchSums, scalarSums)) {
+      std::cerr << "AVX2 and scalar select sums differ" << std::endl;
+      return 1;
+    }
+    std::cout << "batch (scalar select)  " << nhits/tBatchScalar << " hits/s  speedup "
+	      << tScalar/tBatchScalar << std::endl;
+  }
+
+  std::cout << "per-hit loop           " << nhits/tScalar << " hits/s" << std::endl;
+
+  // the step1 hit loop of each job configuration, on rechit collections
+  std::vector<EBRecHitCollection> barrelHits(nevents);
+  std::vector<EERecHitCollection> endcapHits(nevents);
+  for (int iev=0; iev<nevents; iev++) {
+    const Event& ev = events[iev];
+    for (size_t i=0; i<ev.hi_barl.size(); i++)
+      barrelHits[iev].push_back(EcalRecHit(EBDetId::unhashIndex(ev.hi_barl[i]), ev.e_barl[i], 0.));
+    for (size_t i=0; i<ev.hi_endc.size(); i++)
+      endcapHits[iev].push_back(EcalRecHit(EEDetId::unhashIndex(ev.hi_endc[i]), ev.e_endc[i], 0.));
+  }
+
+  EcalPhiSymConstants constants;
+  if (reiterate) {
+    constants.barl_ = calibs[0];
+    constants.endc_ = calibs[1];
+  } else {
+    std::normal_distribution<float> calib(1., 0.02);
+    for (unsigned int i=0; i<constants.barl_.size(); i++) constants.barl_[i] = calib(rng);
+    for (unsigned int i=0; i<constants.endc_.size(); i++) constants.endc_[i] = calib(rng);
+  }
+
+  std::cout << "hit loop                              specialized      generic  (hits/s)" << std::endl;
+  for (int imode=0; imode<6; imode++) {
+
+    // spectra only with the k-factor scan, eventSet 1
+    Modes modes;
+    modes.reiterate = imode%2;
+    modes.kscan     = imode/2>0;
+    modes.spectra   = imode/2==2;
+    for (int i=0; i<EcalPhiSymStep1Algo::kNMiscalBinsEB; i++)
+      modes.miscalEB[i] = (1-EcalPhiSymStep1Algo::kMiscalRangeEB) +
+	float(i)*(2*EcalPhiSymStep1Algo::kMiscalRangeEB/(EcalPhiSymStep1Algo::kNMiscalBinsEB-1));
+    for (int i=0; i<EcalPhiSymStep1Algo::kNMiscalBinsEE; i++)
+      modes.miscalEE[i] = (1-EcalPhiSymStep1Algo::kMiscalRangeEE) +
+	float(i)*(2*EcalPhiSymStep1Algo::kMiscalRangeEE/(EcalPhiSymStep1Algo::kNMiscalBinsEE-1));
+
+    edm::ParameterSet pset;
+    pset.addParameter<double>("eCut_barrel", 0.55);
+    pset.addParameter<double>("ap", -0.150);
+    pset.addParameter<double>("b", 0.600);
+    pset.addParameter<int>("eventSet", modes.kscan ? 1 : 2);
+    pset.addUntrackedParameter<bool>("reiteration", modes.reiterate);
+    pset.addUntrackedParameter<bool>("fixedPointSums", fixedPoint);
+    pset.addUntrackedParameter<std::string>("spectraFile", modes.spectra ? "Espectra.root" : "");
+
+    EcalPhiSymStep1Algo algo(pset);
+    algo.setUp(crystals, constants);
+
+    EcalPhiSymStep1Sums specialized, generic;
+    algo.book(specialized);
+    algo.book(generic);
+
+    double tSpecialized=0., tGeneric=0.;
+    for (int irep=0; irep<repeats; irep++) {
+      specialized.reset();
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (int iev=0; iev<nevents; iev++)
+	algo.accumulate(barrelHits[iev], endcapHits[iev], specialized);
+      double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      if (irep==0 || t<tSpecialized) tSpecialized = t;
+
+      generic.reset();
+      start = std::chrono::steady_clock::now();
+      for (int iev=0; iev<nevents; iev++)
+	genericHits(barrelHits[iev], endcapHits[iev], crystals, constants, modes, generic);
+      t = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      if (irep==0 || t<tGeneric) tGeneric = t;
+    }
+
+    if (state(specialized)!=state(generic)) {
+      std::cerr << "Specialized and generic sums differ" << std::endl;
+      return 1;
+    }
+
+    std::cout << "accumulateHits<" << (modes.reiterate ? "true, " : "false,")
+	      << (modes.kscan ? "true, " : "false,") << (modes.spectra ? "true> " : "false>")
+	      << std::setw(14) << nhits/tSpecialized << std::setw(13) << nhits/tGeneric
+	      << "  speedup " << tGeneric/tSpecialized << std::endl;
+  }
+
+  return 0;
+}
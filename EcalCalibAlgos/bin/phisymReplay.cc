@@ -0,0 +1,215 @@
+//
+// Replay the step1 accumulation over hit caches written with hitCache
+// set, with other cuts and previous constants, and write the ET sums as
+// etsum_barl_N.dat and etsum_endc_N.dat for step2.
+//
+// The caches are mapped in memory; their events are split in contiguous
+// ranges, one per thread, each thread filling its own sums, which are
+// added in range order so that the result does not depend on timing.
+//
+// Only the main ET sums are replayed: k factors, spectra, subsets and
+// bins come from the original step1 jobs. Cuts (times the previous
+// constants) outside the cache window written by step1 lose hits.
+//
+// usage: phisymReplay [options] hitcache_1.bin [hitcache_1_1.bin ...]
+//
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitCache.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitBatch.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConstants.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymLumiMask.h"
+
+#include "CondTools/Ecal/interface/EcalIntercalibConstantsXMLTranslator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace {
+
+  void usage(const char* prog){
+    std::cerr << "usage: " << prog << " [options] hitcache files\n"
+	      << "  -e eCut_barrel   barrel energy cut (0.55)\n"
+	      << "  -a ap            EE cut offset, e_cut = ap + eta_ring*b (-0.150)\n"
+	      << "  -b b             EE cut slope (0.600)\n"
+	      << "  -c calib.xml     previous constants, as when reiterating\n"
+	      << "  -l mask.json     certified lumi sections, events of others skipped\n"
+	      << "  -s threshold     channel status threshold (3)\n"
+	      << "  -g               accumulate good channels only\n"
+	      << "  -f               ET sums as integer keV\n"
+	      << "  -n eventSet      eventSet of the output files (1)\n"
+	      << "  -j threads       threads (all cores)\n";
+  }
+
+  void addBarl(EcalPhiSymHitBatch& batch, const EcalPhiSymCrystalTable& crystals,
+	       EcalPhiSymAccumulator& acc){
+    batch.select(&crystals.invCosh_barl_[0], &crystals.eCut_barl_[0],
+		 &crystals.etThr_barl_[0], &crystals.sel_barl_[0]);
+    if (acc.fixedPoint()) {
+      batch.accumulateMoments(&acc.esumKeV_barl_[0], &acc.et2sumKeV_barl_[0],
+			      &acc.e2sumKeV_barl_[0], acc.overflows_);
+      batch.accumulate(&acc.etsumKeV_barl_[0], &acc.nhits_barl_[0], acc.overflows_);
+    } else {
+      batch.accumulateMoments(&acc.esum_barl_[0], &acc.et2sum_barl_[0], &acc.e2sum_barl_[0]);
+      batch.accumulate(&acc.etsum_barl_[0], &acc.nhits_barl_[0]);
+    }
+    batch.clear();
+  }
+
+  void addEndc(EcalPhiSymHitBatch& batch, const EcalPhiSymCrystalTable& crystals,
+	       EcalPhiSymAccumulator& acc){
+    batch.select(&crystals.invCosh_endc_[0], &crystals.eCut_endc_[0],
+		 &crystals.etThr_endc_[0], &crystals.sel_endc_[0]);
+    if (acc.fixedPoint()) {
+      batch.accumulateMoments(&acc.esumKeV_endc_[0], &acc.et2sumKeV_endc_[0],
+			      &acc.e2sumKeV_endc_[0], acc.overflows_);
+      batch.accumulate(&acc.etsumKeV_endc_[0], &acc.nhits_endc_[0], acc.overflows_);
+    } else {
+      batch.accumulateMoments(&acc.esum_endc_[0], &acc.et2sum_endc_[0], &acc.e2sum_endc_[0]);
+      batch.accumulate(&acc.etsum_endc_[0], &acc.nhits_endc_[0]);
+    }
+    batch.clear();
+  }
+
+  /// accumulate events [first,last) of the index; batches run across
+  /// events, the ET sums do not need the boundaries
+  void replay(const EcalPhiSymHitCacheReader& cache, const std::vector<size_t>& events,
+	      size_t first, size_t last, const EcalPhiSymCrystalTable& crystals,
+	      const EcalPhiSymConstants* calibs, EcalPhiSymAccumulator& sums){
+
+    const uint32_t nBarl = crystals.invCosh_barl_.size();
+    const uint32_t nEndc = crystals.invCosh_endc_.size();
+
+    EcalPhiSymHitBatch barl, endc;
+    for (size_t iev=first; iev<last; iev++) {
+      const phisym::HitCacheRecord& r = cache.record(events[iev]);
+      const phisym::HitCacheHit* hits = cache.hits(events[iev]);
+
+      for (uint32_t i=0; i<r.a; i++) {
+	uint32_t hi = hits[i].hashedIndex;
+	if (hi>=nBarl) continue;
+	barl.push(hi, hits[i].energy, calibs ? calibs->barl_[hi] : 1.f);
+	if (barl.full()) addBarl(barl, crystals, sums);
+      }
+
+      hits += r.a;
+      for (uint32_t i=0; i<r.b; i++) {
+	uint32_t hi = hits[i].hashedIndex;
+	if (hi>=nEndc) continue;
+	endc.push(hi, hits[i].energy, calibs ? calibs->endc_[hi] : 1.f);
+	if (endc.full()) addEndc(endc, crystals, sums);
+      }
+    }
+
+    if (barl.n) addBarl(barl, crystals, sums);
+    if (endc.n) addEndc(endc, crystals, sums);
+  }
+
+}
+
+
+int main(int argc, char** argv){
+
+  double eCut_barl = 0.55;
+  double ap = -0.150;
+  double b  = 0.600;
+  std::string calibFile;
+  EcalPhiSymLumiMask lumiMask;
+  int statusThreshold = 3;
+  bool allChannels = true;
+  bool fixedPoint = false;
+  int eventSet = 1;
+  unsigned int nthreads = std::thread::hardware_concurrency();
+
+  int opt;
+  while ((opt = getopt(argc, argv, "e:a:b:c:l:s:gfn:j:h"))!=-1) {
+    switch (opt) {
+    case 'e': eCut_barl = atof(optarg); break;
+    case 'a': ap = atof(optarg); break;
+    case 'b': b = atof(optarg); break;
+    case 'c': calibFile = optarg; break;
+    case 'l': if (!lumiMask.load(optarg)) return 1; break;
+    case 's': statusThreshold = atoi(optarg); break;
+    case 'g': allChannels = false; break;
+    case 'f': fixedPoint = true; break;
+    case 'n': eventSet = atoi(optarg); break;
+    case 'j': nthreads = atoi(optarg); break;
+    default: usage(argv[0]); return 1;
+    }
+  }
+  if (optind>=argc) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (nthreads<1) nthreads=1;
+
+  EcalPhiSymConstants calibs;
+  if (!calibFile.empty()) {
+    EcalCondHeader h;
+    EcalIntercalibConstants constants;
+    if (EcalIntercalibConstantsXMLTranslator::readXML(calibFile, h, constants)) {
+      std::cerr << "Error reading " << calibFile << std::endl;
+      return 1;
+    }
+    calibs.load(constants);
+  }
+
+  EcalPhiSymAccumulator sums;
+  sums.setFixedPoint(fixedPoint);
+
+  unsigned long long nevents=0;
+  unsigned long long nskipped=0;
+  for (int ifile=optind; ifile<argc; ifile++) {
+
+    EcalPhiSymHitCacheReader cache;
+    if (!cache.open(argv[ifile])) return 1;
+
+    // status codes are merged over the caches, as over step1 jobs
+    EcalPhiSymCrystalTable crystals;
+    cache.table(crystals, statusThreshold, allChannels);
+    crystals.setCuts(eCut_barl, ap, b);
+    cache.setup(sums, statusThreshold);
+
+    std::vector<size_t> events;
+    unsigned int nlumis;
+    cache.index(events, nlumis, &lumiMask, &nskipped);
+
+    unsigned int nranges = std::min<size_t>(nthreads, std::max<size_t>(events.size(), 1));
+    std::vector<EcalPhiSymAccumulator> rangeSums(nranges);
+    std::vector<std::thread> threads;
+    for (unsigned int i=0; i<nranges; i++) {
+      rangeSums[i].setFixedPoint(fixedPoint);
+      size_t first = events.size()*i/nranges;
+      size_t last  = events.size()*(i+1)/nranges;
+      threads.push_back(std::thread(replay, std::cref(cache), std::cref(events), first, last,
+				    std::cref(crystals), calibFile.empty() ? 0 : &calibs,
+				    std::ref(rangeSums[i])));
+    }
+    for (unsigned int i=0; i<nranges; i++) {
+      threads[i].join();
+      sums.add(rangeSums[i]);
+    }
+
+    std::cout << argv[ifile] << ": " << events.size() << " events in "
+	      << nlumis << " lumi sections" << std::endl;
+    nevents += events.size();
+  }
+
+  std::ostringstream barlFile, endcFile;
+  barlFile << "etsum_barl_" << eventSet << ".dat";
+  endcFile << "etsum_endc_" << eventSet << ".dat";
+  sums.write(barlFile.str(), endcFile.str(), eventSet);
+
+  std::cout << "Events replayed " << nevents << ", skipped " << nskipped << std::endl;
+  return 0;
+}
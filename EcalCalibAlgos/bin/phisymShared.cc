@@ -0,0 +1,76 @@
+//
+// Show the node totals of the step1 shared sums (sharedSums set) while
+// the jobs run, and write them as etsum_barl_N.dat and etsum_endc_N.dat
+// when a job died before the last one could, then remove the segment.
+//
+// usage: phisymShared [options] /phisym_node
+//
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymSharedSums.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+
+namespace {
+
+  void usage(const char* prog){
+    std::cerr << "usage: " << prog << " [options] segment\n"
+	      << "  -w eventSet      write the ET sums for this eventSet\n"
+	      << "  -s threshold     channel status threshold (3)\n"
+	      << "  -r               remove the segment\n";
+  }
+
+}
+
+
+int main(int argc, char** argv){
+
+  int eventSet = 0;
+  int statusThreshold = 3;
+  bool remove = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "w:s:rh"))!=-1) {
+    switch (opt) {
+    case 'w': eventSet = atoi(optarg); break;
+    case 's': statusThreshold = atoi(optarg); break;
+    case 'r': remove = true; break;
+    default: usage(argv[0]); return 1;
+    }
+  }
+  if (optind!=argc-1) {
+    usage(argv[0]);
+    return 1;
+  }
+  std::string name = argv[optind];
+
+  EcalPhiSymSharedSums shared;
+  if (!shared.attach(name, false, 0, true)) return 1;
+  shared.print(std::cout);
+
+  if (eventSet) {
+    if (!shared.header().hasRings)
+      std::cerr << "No event merged yet, endcap rings unknown" << std::endl;
+
+    EcalPhiSymAccumulator sums;
+    sums.setFixedPoint(shared.header().fixedPoint);
+    shared.load(sums, statusThreshold);
+
+    std::ostringstream barlFile, endcFile;
+    barlFile << "etsum_barl_" << eventSet << ".dat";
+    endcFile << "etsum_endc_" << eventSet << ".dat";
+    sums.write(barlFile.str(), endcFile.str(), eventSet);
+  }
+
+  if (remove && !EcalPhiSymSharedSums::remove(name)) {
+    std::cerr << "Can't remove " << name << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -26,6 +26,10 @@ class EcalGeomPhiSymHelper {
 	     const EcalChannelStatus* chstatus,
 	     int statusThreshold);
 
+  /// good cells and bad cell counts again from the status codes, for a
+  /// module with another threshold than the EventSetup helper
+  void applyStatusThreshold(int statusThreshold);
+
   GlobalPoint cellPos_[kEndcWedgesX][kEndcWedgesY];
   double cellPhi_     [kEndcWedgesX][kEndcWedgesY];  
   double cellArea_    [kEndcWedgesX][kEndcWedgesY];
@@ -38,8 +42,13 @@ class EcalGeomPhiSymHelper {
   // informations about good cells
   bool goodCell_barl[kBarlRings][kBarlWedges][kSides];
   bool goodCell_endc[kEndcWedgesX][kEndcWedgesX][kSides];   
+  // channel status code (low 5 bits)
+  int statusCode_barl[kBarlRings][kBarlWedges][kSides];
+  int statusCode_endc[kEndcWedgesX][kEndcWedgesY][kSides];
   int nBads_barl[kBarlRings];
   int nBads_endc[kEndcEtaRings];
+  // threshold of the good cells
+  int statusThreshold_;
 
 };
 
@@ -0,0 +1,41 @@
+#ifndef Calibration_EcalCalibAlgos_EcalGeomPhiSymHelperESProducer_h
+#define Calibration_EcalCalibAlgos_EcalGeomPhiSymHelperESProducer_h
+
+//
+// Package:    Calibration/EcalCalibAlgos
+// Class:      EcalGeomPhiSymHelperESProducer
+// 
+//
+// Description: the EcalGeomPhiSymHelper in the EventSetup, computed
+//              once per geometry and channel status IOV and shared by
+//              the step1 and step2 modules of the job and their
+//              streams, with esGeomHelper set. Good cells from
+//              statusThreshold; a module with another threshold
+//              applies its own to its copy.
+//
+
+#include <memory>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHelperRcd.h"
+
+#include "FWCore/Framework/interface/ESProducer.h"
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+
+
+class EcalGeomPhiSymHelperESProducer : public edm::ESProducer {
+
+ public:
+
+  explicit EcalGeomPhiSymHelperESProducer(const edm::ParameterSet& iConfig);
+
+  std::unique_ptr<EcalGeomPhiSymHelper> produce(const EcalPhiSymHelperRcd& record);
+
+ private:
+
+  int statusThreshold_;
+
+};
+
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymAccumulator_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymAccumulator_h_
+
+//
+// Per-crystal phi-symmetry sums shared by step1 and step2, stored as
+// flat arrays indexed by EBDetId::hashedIndex() and
+// EEDetId::hashedIndex().
+//
+// In the barrel the hashed index is ring-major: the 360 crystals of
+// ring (ieta,sign) are contiguous, starting at barlIndex(ieta,0,sign).
+// In the endcap the crystals of each (ring,sign) are listed contiguously
+// in endcRingCells(), between endcRingBegin() and endcRingEnd().
+//
+// In fixed-point mode ET is summed as integer keV in etsumKeV_*, so that
+// sums do not depend on the order of hits, streams, jobs and merges.
+// The E sum and the ET^2 and E^2 sums, for the statistical errors, are
+// then integers too, in keV and 1e-6 GeV^2. Files are written with
+// exactly 6 decimals and read back without rounding. etsum_* and the
+// double moments are filled from the integer sums by read() and
+// updateEtSums().
+//
+
+#include <climits>
+#include <cmath>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+
+class EcalPhiSymLumiSums;
+
+class EcalPhiSymAccumulator {
+
+ public:
+
+  EcalPhiSymAccumulator();
+
+  /// build the endcap ring layout, copy the good-cell flags and merge
+  /// the channel status codes of the helper into status_*
+  void setup(const EcalGeomPhiSymHelper& helper);
+
+  /// the same from endcap rings and status codes by hashed index, as
+  /// stored in a hit cache, with good cells from statusThreshold
+  void setup(const std::vector<short>& ring_endc,
+	     const std::vector<unsigned char>& status_barl,
+	     const std::vector<unsigned char>& status_endc,
+	     int statusThreshold);
+
+  /// good cells from the status codes: not above statusThreshold (and
+  /// in an endcap ring)
+  void applyStatusThreshold(int statusThreshold);
+
+  /// sum ET as integer keV
+  void setFixedPoint(bool fixedPoint);
+  bool fixedPoint() const { return fixedPoint_; }
+
+  /// zero all sums
+  void reset();
+
+  /// add the sums of another accumulator
+  void add(const EcalPhiSymAccumulator& other);
+
+  /// write sums in the step1 etsum_barl_N.dat/etsum_endc_N.dat format,
+  /// followed by the channel status code, E, ET^2 and E^2 sums
+  void write(const std::string& barlFile, const std::string& endcFile,
+	     int eventSet) const;
+
+  /// add sums read from (concatenated) step1 output files, with or
+  /// without the status and moment columns; false if a line had no
+  /// moments, which are then incomplete
+  bool read(const std::string& barlFile, const std::string& endcFile);
+
+  /// fill etsum_* and the moments from the integer sums
+  void updateEtSums();
+
+  /// copy the ET and ET^2 sums, hits and status codes to a lumi
+  /// section product
+  void fill(EcalPhiSymLumiSums& lumiSums) const;
+
+  /// add the sums of a lumi section product, max-merging the status
+  void add(const EcalPhiSymLumiSums& lumiSums);
+
+  /// binary dump of the sums for a checkpoint; readState() fails if
+  /// they were dumped with another fixed-point mode
+  void writeState(std::ostream& out) const;
+  bool readState(std::istream& in);
+
+  /// bytes allocated for the sums
+  size_t memory() const;
+
+
+  static long long toKeV(double et) { return llround(et*1e6); }
+
+  /// add q to sum, false (and sum unchanged) if it would overflow
+  static bool addKeV(long long& sum, long long q) {
+    if ((q > 0 && sum > LLONG_MAX - q) || (q < 0 && sum < LLONG_MIN - q))
+      return false;
+    sum += q;
+    return true;
+  }
+
+
+  /// hashed index of barrel crystal ieta=[0,85), iphi=[0,360)
+  static int barlIndex(int ieta, int iphi, int sign) {
+    return (kBarlRings + (sign ? ieta : -ieta-1))*kBarlWedges + iphi;
+  }
+
+  /// hashed index of endcap crystal ix,iy=[0,100), -1 if not a crystal
+  int endcIndex(int ix, int iy, int sign) const {
+    return endcIndex_[(ix*kEndcWedgesY+iy)*kSides+sign];
+  }
+
+  int endcRingBegin(int ring, int sign) const {
+    return endcRingOffsets_[ring+sign*kEndcEtaRings];
+  }
+  int endcRingEnd(int ring, int sign) const {
+    return endcRingOffsets_[ring+sign*kEndcEtaRings+1];
+  }
+  /// endcap hashed indices grouped by (sign,ring), ix-major inside a ring
+  const std::vector<int>& endcRingCells() const { return endcRingCells_; }
+
+  /// endcap access on the ix,iy grid, false/zero where there is no crystal
+  bool goodEndc(int ix, int iy, int sign) const {
+    int hi = endcIndex(ix, iy, sign);
+    return hi>=0 && goodCell_endc_[hi];
+  }
+  unsigned int nhitsEndc(int ix, int iy, int sign) const {
+    int hi = endcIndex(ix, iy, sign);
+    return hi>=0 ? nhits_endc_[hi] : 0;
+  }
+
+
+  // barrel
+  std::vector<double>       etsum_barl_;
+  std::vector<long long>    etsumKeV_barl_;   // fixed-point mode only
+  std::vector<unsigned int> nhits_barl_;
+  std::vector<bool>         goodCell_barl_;
+  std::vector<unsigned char> status_barl_;  // worst status code seen
+  std::vector<double>       esum_barl_;
+  std::vector<double>       et2sum_barl_;
+  std::vector<double>       e2sum_barl_;
+  std::vector<long long>    esumKeV_barl_;    // fixed-point mode only
+  std::vector<long long>    et2sumKeV_barl_;  // 1e-6 GeV^2
+  std::vector<long long>    e2sumKeV_barl_;
+
+  // endcap
+  std::vector<double>       etsum_endc_;
+  std::vector<long long>    etsumKeV_endc_;
+  std::vector<unsigned int> nhits_endc_;
+  std::vector<bool>         goodCell_endc_;
+  std::vector<unsigned char> status_endc_;
+  std::vector<double>       esum_endc_;
+  std::vector<double>       et2sum_endc_;
+  std::vector<double>       e2sum_endc_;
+  std::vector<long long>    esumKeV_endc_;
+  std::vector<long long>    et2sumKeV_endc_;
+  std::vector<long long>    e2sumKeV_endc_;
+
+  /// integer sums that would have overflowed, and were not added
+  unsigned int overflows_;
+
+ private:
+
+  /// endcap ring layout from endcRing_ and the crystals per (ring,sign)
+  void buildRings(const std::vector<int>& ncells);
+
+  bool fixedPoint_;
+
+  std::vector<int>   endcIndex_;        // (ix,iy,sign) -> hashed index
+  std::vector<short> endcRing_;         // hashed index -> ring
+  std::vector<int>   endcRingOffsets_;
+  std::vector<int>   endcRingCells_;
+
+};
+
+
+#endif
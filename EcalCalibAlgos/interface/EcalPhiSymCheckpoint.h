@@ -0,0 +1,118 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymCheckpoint_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymCheckpoint_h_
+
+//
+// Periodic dump of everything step1 has accumulated, so that a job that
+// dies can be restarted from its last checkpoint instead of from the
+// first event. The file holds the completed lumi sections and the full
+// EcalPhiSymStep1Sums; a restarted job with the same configuration adds
+// the sums and skips the events of those lumi sections.
+//
+// Native byte order:
+//
+//   magic "PSCK", version, last completed run and lumi section
+//   number of completed lumi sections, then (run<<32 | lumi) of each
+//   EcalPhiSymStep1Sums::writeState()
+//   magic "KCSP", so that a truncated file is not taken
+//
+// The file is written to <file>.tmp, synced and renamed, so that a
+// crash while writing leaves the previous checkpoint.
+//
+
+#include <stdint.h>
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+class EcalPhiSymStep1Sums;
+
+namespace phisym {
+
+  template <class T>
+  void writePod(std::ostream& out, const T& x) {
+    out.write(reinterpret_cast<const char*>(&x), sizeof(T));
+  }
+
+  template <class T>
+  bool readPod(std::istream& in, T& x) {
+    return bool(in.read(reinterpret_cast<char*>(&x), sizeof(T)));
+  }
+
+  template <class T>
+  void writeVector(std::ostream& out, const std::vector<T>& v) {
+    writePod(out, uint64_t(v.size()));
+    if (!v.empty()) out.write(reinterpret_cast<const char*>(&v[0]), v.size()*sizeof(T));
+  }
+
+  /// false unless the stored size is the size of v, as booked by this
+  /// job's configuration
+  template <class T>
+  bool readVector(std::istream& in, std::vector<T>& v) {
+    uint64_t n;
+    if (!readPod(in, n) || n!=v.size()) return false;
+    return v.empty() || bool(in.read(reinterpret_cast<char*>(&v[0]), n*sizeof(T)));
+  }
+
+}
+
+
+class EcalPhiSymCheckpoint {
+
+ public:
+
+  static const uint32_t kVersion = 2;
+
+  EcalPhiSymCheckpoint();
+
+  /// checkpoint to fileName every everyLumis completed lumi sections
+  /// or everySeconds, whichever comes first (0 to not use one of them);
+  /// inactive with an empty fileName
+  void configure(const std::string& fileName, unsigned int everyLumis,
+		 double everySeconds);
+
+  bool active() const { return !fileName_.empty(); }
+
+  /// add the sums of fileName, if it exists, to sums (booked by the
+  /// same configuration); its lumi sections are then resumed. False,
+  /// and sums unchanged, if the file can't be used
+  bool resume(EcalPhiSymStep1Sums& sums);
+
+  /// lumi section in the checkpoint the job resumed from
+  bool resumed(uint32_t run, uint32_t lumi) const {
+    return !resumed_.empty() && resumed_.count(key(run, lumi));
+  }
+
+  /// record a completed lumi section, unless it was resumed
+  void complete(uint32_t run, uint32_t lumi);
+
+  /// a checkpoint should be written, counting pending lumi sections
+  /// about to complete
+  bool due(unsigned int pending=0) const;
+
+  /// write sums and the lumi sections completed so far
+  bool write(const EcalPhiSymStep1Sums& sums);
+
+ private:
+
+  static uint64_t key(uint32_t run, uint32_t lumi) {
+    return (uint64_t(run) << 32) | lumi;
+  }
+
+  std::string fileName_;
+  unsigned int everyLumis_;
+  double everySeconds_;
+
+  std::set<uint64_t> resumed_;
+  std::vector<uint64_t> completed_;
+  uint64_t last_;
+
+  unsigned int lumisSinceWrite_;
+  time_t lastWrite_;
+
+};
+
+
+#endif
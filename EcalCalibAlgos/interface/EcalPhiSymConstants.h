@@ -0,0 +1,36 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymConstants_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymConstants_h_
+
+//
+// Intercalibration constants as flat float arrays indexed by
+// EBDetId::hashedIndex() and EEDetId::hashedIndex(), for lookups in
+// the hit and crystal loops. EcalIntercalibConstants is only used to
+// load from and store to the conditions/XML format.
+//
+
+#include <vector>
+
+#include "CondFormats/EcalObjects/interface/EcalIntercalibConstants.h"
+
+class EcalPhiSymConstants {
+
+ public:
+
+  /// all crystals set to value
+  explicit EcalPhiSymConstants(float value=1.);
+
+  void fill(float value);
+
+  /// copy the constants of all crystals from the container
+  void load(const EcalIntercalibConstants& constants);
+
+  /// set the constants of all crystals in the container
+  void store(EcalIntercalibConstants& constants) const;
+
+  std::vector<float> barl_;
+  std::vector<float> endc_;
+
+};
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymConvergence_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymConvergence_h_
+
+//
+// Per-ring convergence of the step1 ET sums, over the good crystals of
+// each ring: mean and relative spread of the crystal ET sums, and the
+// expected statistical precision of a crystal ET sum,
+// sqrt(sum ET^2)/sum ET, which is the ET spread over sqrt(nhits),
+// averaged in quadrature over the crystals. The precision of the
+// constants is this over the k factor of the ring.
+//
+// Rings with a good crystal without hits have precision 1; rings
+// without good crystals are not counted.
+//
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+
+class EcalPhiSymAccumulator;
+class EcalPhiSymCrystalTable;
+
+class EcalPhiSymConvergence {
+
+ public:
+
+  void compute(const EcalPhiSymAccumulator& sums,
+	       const EcalPhiSymCrystalTable& crystals);
+
+  /// every counted ring at or below the target precision
+  bool converged(double target) const;
+
+  /// worst precision of the barrel (endcap) rings, and its ring and sign
+  double worstBarl(int& ring, int& sign) const;
+  double worstEndc(int& ring, int& sign) const;
+
+  /// largest relative spread of the crystal ET sums of a ring
+  double maxSpreadBarl() const;
+  double maxSpreadEndc() const;
+
+  int    ngood_barl_    [kBarlRings][kSides];
+  double mean_barl_     [kBarlRings][kSides];
+  double spread_barl_   [kBarlRings][kSides];
+  double precision_barl_[kBarlRings][kSides];
+
+  int    ngood_endc_    [kEndcEtaRings][kSides];
+  double mean_endc_     [kEndcEtaRings][kSides];
+  double spread_endc_   [kEndcEtaRings][kSides];
+  double precision_endc_[kEndcEtaRings][kSides];
+
+};
+
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymCrystalTable_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymCrystalTable_h_
+
+//
+// Per-crystal quantities used by the step1 hit selection, precomputed
+// once so that selecting a rechit is a table load and two compares.
+// Barrel columns are indexed by EBDetId::hashedIndex(), endcap columns
+// by EEDetId::hashedIndex().
+//
+
+#include <vector>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+
+class CaloGeometry;
+
+class EcalPhiSymCrystalTable {
+
+ public:
+
+  /// fill the table from the geometry and the good-cell flags of the
+  /// helper; EE cut is parametrized as e_cut = ap + eta_ring*b.
+  /// With allChannels hits of bad cells are selected too, to be masked
+  /// in step2 from their status code
+  void setup(const CaloGeometry* geometry,
+	     const EcalGeomPhiSymHelper& helper,
+	     double eCut_barl, double ap, double b,
+	     bool allChannels=false);
+
+  /// recompute eCut and etThr from the eta columns, without geometry
+  void setCuts(double eCut_barl, double ap, double b);
+
+  // barrel
+  std::vector<float> eta_barl_;
+  std::vector<float> invCosh_barl_;   // 1/cosh(eta)
+  std::vector<float> eCut_barl_;      // lower energy cut
+  std::vector<float> etThr_barl_;     // upper ET threshold
+  std::vector<short> ring_barl_;      // abs(ieta)-1
+  std::vector<char>  sign_barl_;      // 1 for EB+, 0 for EB-
+  std::vector<int>   good_barl_;      // int, gathered like the floats
+  std::vector<int>   sel_barl_;       // hits accumulated: good, or all
+
+  // endcap
+  std::vector<float> eta_endc_;       // abs(eta)
+  std::vector<float> invCosh_endc_;
+  std::vector<float> eCut_endc_;
+  std::vector<float> etThr_endc_;
+  std::vector<short> ring_endc_;      // endcap eta ring, -1 if none
+  std::vector<char>  sign_endc_;
+  std::vector<int>   good_endc_;
+  std::vector<int>   sel_endc_;       // good, or all in a ring
+
+  /// abs(eta) of each endcap ring, for the EE cut
+  std::vector<float> etaRing_;
+
+};
+
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymEnergyHistos_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymEnergyHistos_h_
+
+//
+// Per-crystal histograms of the uncalibrated hit ET, uint32 counts in
+// uniform bins over a window around the cuts, one range for the barrel
+// and one for the endcaps. Crystals are indexed by hashed DetId.
+//
+// They let step2 apply other cuts and other previous constants without
+// the rechits: a crystal's ET sum is rebuilt from the bin centres.
+//
+// The text file has a "# nbins lowEB highEB lowEE highEE" header and a
+// line "eventSet det hashedIndex counts..." per crystal with hits, det
+// being 0 for EB and 1 for EE; files can be concatenated.
+//
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class EcalPhiSymEnergyHistos {
+
+ public:
+
+  EcalPhiSymEnergyHistos();
+
+  void book(int nbins, double lowEB, double highEB, double lowEE, double highEE);
+  bool booked() const { return nbins_>0; }
+
+  /// zero all counts
+  void reset();
+
+  /// add the counts of another copy with the same binning
+  void add(const EcalPhiSymEnergyHistos& other);
+
+  /// binary dump of the counts for a checkpoint; readState() fails
+  /// if they were dumped with another number of bins
+  void writeState(std::ostream& out) const;
+  bool readState(std::istream& in);
+
+  /// bytes allocated for the counts
+  size_t memory() const {
+    return (counts_barl_.capacity() + counts_endc_.capacity())*sizeof(unsigned int);
+  }
+
+  void fillBarl(int hi, float et) {
+    int b = bin(0, et);
+    if (b>=0) counts_barl_[hi*nbins_+b]++;
+  }
+  void fillEndc(int hi, float et) {
+    int b = bin(1, et);
+    if (b>=0) counts_endc_[hi*nbins_+b]++;
+  }
+
+  void write(const std::string& fileName, int eventSet) const;
+
+  /// add the counts of a (concatenated) file, booking from its first
+  /// header if needed; false if a header does not match the binning
+  bool read(const std::string& fileName);
+
+  int nbins() const { return nbins_; }
+
+  /// ET at the centre of a bin, det 0 for EB and 1 for EE
+  double center(int det, int b) const { return low_[det] + (b+.5)*width_[det]; }
+
+  const unsigned int* barl(int hi) const { return &counts_barl_[hi*nbins_]; }
+  const unsigned int* endc(int hi) const { return &counts_endc_[hi*nbins_]; }
+
+ private:
+
+  /// bin of et, -1 outside the window
+  int bin(int det, float et) const {
+    double x = (et - low_[det])/width_[det];
+    if (!(x >= 0.) || x >= nbins_) return -1;
+    return int(x);
+  }
+
+  int    nbins_;
+  double low_[2];
+  double high_[2];
+  double width_[2];
+
+  std::vector<unsigned int> counts_barl_;
+  std::vector<unsigned int> counts_endc_;
+
+};
+
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymEventBins_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymEventBins_h_
+
+//
+// Event-level binning of the step1 sums: number of good vertices,
+// bunch crossing and a set of L1 technical bits. Each configured key
+// contributes one field of a packed 32-bit bin key:
+//
+//   bits 24-31  nvtx bin, upper_bound in nvtxEdges (0 below the first edge)
+//   bits 12-23  bx bin, upper_bound in bxEdges
+//   bits  0-11  mask of the fired l1TechBits, bit i for l1TechBits[i]
+//
+// label() turns a key into the file prefix of the bin, e.g.
+// "nvtx2_bx0_l1m3", made of the configured keys only.
+//
+
+#include <string>
+#include <vector>
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+
+class EcalPhiSymEventBins {
+
+ public:
+
+  static const unsigned int kMaxNvtxBins = 255;
+  static const unsigned int kMaxBxBins   = 4095;
+  static const unsigned int kMaxL1Bits   = 12;
+
+  /// no binning
+  EcalPhiSymEventBins();
+
+  /// from the "binning" PSet of the step1 module
+  explicit EcalPhiSymEventBins(const edm::ParameterSet& pset);
+
+  /// any key configured
+  bool active() const { return useNvtx_ || useBx_ || useL1_; }
+
+  /// maximum number of bins filled by one job, events of further bins
+  /// are not binned
+  unsigned int maxBins() const { return maxBins_; }
+
+  unsigned int key(const edm::Event& event) const;
+
+  std::string label(unsigned int key) const;
+
+ private:
+
+  static unsigned int findBin(const std::vector<int>& edges, int value);
+
+  bool useNvtx_;
+  edm::InputTag vertices_;
+  std::vector<int> nvtxEdges_;
+
+  bool useBx_;
+  std::vector<int> bxEdges_;
+
+  bool useL1_;
+  edm::InputTag l1GtRecord_;
+  std::vector<int> l1TechBits_;
+
+  unsigned int maxBins_;
+
+};
+
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymHelperRcd_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymHelperRcd_h_
+
+//
+// Record of the EcalGeomPhiSymHelper, so that it is produced again
+// when the geometry or the channel status change, and only then.
+//
+
+#include "boost/mpl/vector.hpp"
+
+#include "FWCore/Framework/interface/DependentRecordImplementation.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+
+class EcalPhiSymHelperRcd :
+  public edm::eventsetup::DependentRecordImplementation<EcalPhiSymHelperRcd,
+    boost::mpl::vector<CaloGeometryRecord, EcalChannelStatusRcd> > {};
+
+
+#endif
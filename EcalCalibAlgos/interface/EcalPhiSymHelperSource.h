@@ -0,0 +1,44 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymHelperSource_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymHelperSource_h_
+
+//
+// Where a module gets its EcalGeomPhiSymHelper: with esGeomHelper, a
+// copy of the one of EcalGeomPhiSymHelperESProducer (esGeomHelperLabel
+// for a labelled one), otherwise built from the geometry and channel
+// status as before. Either way update() only refreshes it when those
+// records changed, so that a run with a new channel status gets its
+// masks and the others cost nothing.
+//
+
+#include <string>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHelperRcd.h"
+
+#include "FWCore/Framework/interface/ESWatcher.h"
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+
+class EcalPhiSymHelperSource {
+
+ public:
+
+  explicit EcalPhiSymHelperSource(const edm::ParameterSet& iConfig);
+
+  /// refresh helper, good cells from statusThreshold, if the records
+  /// changed since the last call; false if they did not
+  bool update(const edm::EventSetup& setup, int statusThreshold,
+	      EcalGeomPhiSymHelper& helper);
+
+ private:
+
+  bool fromEventSetup_;
+  std::string label_;
+
+  edm::ESWatcher<EcalPhiSymHelperRcd> helperWatcher_;
+  edm::ESWatcher<CaloGeometryRecord>  geometryWatcher_;
+  edm::ESWatcher<EcalChannelStatusRcd> statusWatcher_;
+
+};
+
+
+#endif
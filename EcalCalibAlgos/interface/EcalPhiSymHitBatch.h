@@ -0,0 +1,73 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymHitBatch_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymHitBatch_h_
+
+//
+// A chunk of rechits gathered from a collection, selected in one pass
+// against the columns of EcalPhiSymCrystalTable.
+//
+// select() computes et = e/cosh(eta)*calib and e = e*calib and sets
+// pass[i] for e > eCut && et < etThr && good, 8 hits at a time with
+// AVX2 when the CPU has it, whatever the compiler flags. accumulate()
+// then scatter-adds the selected hits.
+// recut() re-evaluates pass[] for another set of cuts on the same
+// energies.
+//
+
+class EcalPhiSymHitBatch {
+
+ public:
+
+  static const int kSize = 256;
+
+  EcalPhiSymHitBatch() : n(0) {}
+
+  void clear() { n=0; }
+  bool full() const { return n==kSize; }
+
+  void push(int hashedIndex, float energy, float calib) {
+    hi[n]    = hashedIndex;
+    e[n]     = energy;
+    scale[n] = calib;
+    n++;
+  }
+
+  /// true if select() and recut() run the AVX2 kernel
+  static bool avx2();
+
+  /// use the AVX2 kernel if the CPU has it, or the scalar one; the
+  /// choice is made once at load time and is only changed to compare them
+  static void setAvx2(bool on);
+
+  /// evaluate the cuts; table columns are indexed by hashed index
+  void select(const float* invCosh, const float* eCut,
+	      const float* etThr, const int* good);
+
+  /// evaluate other cuts on the energies computed by select()
+  void recut(const float* eCut, const float* etThr, const int* good);
+
+  /// add et and a hit for every selected entry, return number selected
+  int accumulate(double* etsum, unsigned int* nhits) const;
+
+  /// same, with et added as integer keV; additions that would
+  /// overflow are dropped and counted
+  int accumulate(long long* etsumKeV, unsigned int* nhits,
+		 unsigned int& overflows) const;
+
+  /// add e, et^2 and e^2 for every selected entry
+  void accumulateMoments(double* esum, double* et2sum, double* e2sum) const;
+
+  /// same, in integer keV and 1e-6 GeV^2
+  void accumulateMoments(long long* esumKeV, long long* et2sumKeV, long long* e2sumKeV,
+			 unsigned int& overflows) const;
+
+  int   n;
+  int   hi   [kSize];
+  float e    [kSize];     // energy, calibrated after select()
+  float et   [kSize];     // transverse energy, filled by select()
+  float scale[kSize];     // previous calibration, 1 if not iterating
+  int   pass [kSize];
+
+};
+
+
+#endif
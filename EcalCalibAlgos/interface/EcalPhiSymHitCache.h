@@ -0,0 +1,177 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymHitCache_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymHitCache_h_
+
+//
+// Compact binary stream of the rechits in a loose window around the
+// step1 cuts, so that the accumulation can be replayed with other cuts
+// and constants without unpacking and reconstructing the RAW data
+// again (bin/phisymReplay.cc).
+//
+// Native byte order, every block a multiple of 8 bytes:
+//
+//   Header        magic "PSHC", version, crystal and ring counts, window
+//   crystal table eta (float) of the barrel and endcap crystals by
+//                 hashed index, abs(eta) of the endcap rings, endcap
+//                 ring (int16) and barrel and endcap channel status
+//                 (uint8); zero padded
+//   Record        kLumi: a=run, b=lumi section, written before the first
+//                 event of each lumi section
+//                 kEvent: a=barrel hits, b=endcap hits, event=event
+//                 number, followed by a+b Hit, barrel first
+//
+// Hit energies are the uncalibrated rechit energies; hits are kept if
+// e > window[0]*eCut and et < window[1]*etThr of the job's cuts.
+//
+
+#include <stdint.h>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "DataFormats/Provenance/interface/EventID.h"
+
+class EcalGeomPhiSymHelper;
+class EcalPhiSymCrystalTable;
+class EcalPhiSymAccumulator;
+class EcalPhiSymLumiMask;
+
+namespace phisym {
+
+  struct HitCacheHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t nBarl;
+    uint32_t nEndc;
+    uint32_t nRings;
+    float    windowLow;
+    float    windowHigh;
+    uint32_t reserved;
+  };
+
+  struct HitCacheRecord {
+    enum Type { kLumi=1, kEvent=2 };
+    uint32_t type;
+    uint32_t a;
+    uint32_t b;
+    uint32_t reserved;
+    uint64_t event;
+  };
+
+  struct HitCacheHit {
+    uint32_t hashedIndex;
+    float    energy;
+  };
+
+}
+
+
+class EcalPhiSymHitCache {
+
+ public:
+
+  static const uint32_t kVersion = 1;
+
+  EcalPhiSymHitCache();
+
+  /// create fileName and write the header and the crystal table;
+  /// false if the file can't be opened
+  bool open(const std::string& fileName,
+	    const EcalPhiSymCrystalTable& crystals,
+	    const EcalGeomPhiSymHelper& helper,
+	    float windowLow, float windowHigh);
+
+  bool isOpen() const { return out_.is_open(); }
+
+  void close();
+
+  /// hits of the current event, the barrel ones first
+  void clear() { hits_.clear(); nBarl_=0; }
+  void addBarl(int hi, float energy) {
+    phisym::HitCacheHit hit = {uint32_t(hi), energy};
+    hits_.push_back(hit);
+    nBarl_++;
+  }
+  void addEndc(int hi, float energy) {
+    phisym::HitCacheHit hit = {uint32_t(hi), energy};
+    hits_.push_back(hit);
+  }
+
+  /// write the event record and its hits, preceded by a lumi record
+  /// when the lumi section changes
+  void write(const edm::EventID& id);
+
+  unsigned long long events() const { return events_; }
+
+ private:
+
+  std::ofstream out_;
+  std::vector<char> buffer_;
+
+  std::vector<phisym::HitCacheHit> hits_;
+  uint32_t nBarl_;
+
+  uint32_t run_;
+  uint32_t lumi_;
+  unsigned long long events_;
+
+};
+
+
+/// read-only view of a hit cache file, mapped in memory
+class EcalPhiSymHitCacheReader {
+
+ public:
+
+  EcalPhiSymHitCacheReader();
+  ~EcalPhiSymHitCacheReader();
+
+  /// map fileName and check its header; false and an error message if
+  /// it is not a hit cache of this version
+  bool open(const std::string& fileName);
+  void close();
+
+  const phisym::HitCacheHeader& header() const { return *header_; }
+
+  /// crystal table columns, setCuts() still to be called
+  void table(EcalPhiSymCrystalTable& crystals,
+	     int statusThreshold, bool allChannels) const;
+
+  /// endcap rings and status codes of the sums
+  void setup(EcalPhiSymAccumulator& sums, int statusThreshold) const;
+
+  /// offsets of the event records, and the number of lumi sections;
+  /// events of lumi sections not in mask are left out and counted in
+  /// nskipped. False if the file is truncated or corrupt (events up to
+  /// there are kept)
+  bool index(std::vector<size_t>& events, unsigned int& nlumis,
+	     const EcalPhiSymLumiMask* mask=0, unsigned long long* nskipped=0) const;
+
+  const phisym::HitCacheRecord& record(size_t offset) const {
+    return *reinterpret_cast<const phisym::HitCacheRecord*>(data_+offset);
+  }
+  const phisym::HitCacheHit* hits(size_t offset) const {
+    return reinterpret_cast<const phisym::HitCacheHit*>(data_+offset+sizeof(phisym::HitCacheRecord));
+  }
+
+ private:
+
+  EcalPhiSymHitCacheReader(const EcalPhiSymHitCacheReader&);
+  EcalPhiSymHitCacheReader& operator=(const EcalPhiSymHitCacheReader&);
+
+  const char* data_;
+  size_t size_;
+  size_t begin_;       // first record
+
+  const phisym::HitCacheHeader* header_;
+  const float* eta_barl_;
+  const float* eta_endc_;
+  const int16_t* ring_endc_;
+  const uint8_t* status_barl_;
+  const uint8_t* status_endc_;
+  const float* etaRing_;
+
+};
+
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymLumiMask_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymLumiMask_h_
+
+//
+// Certified lumi sections, from a JSON file in the format of
+// json_Golden.txt: {"run": [[first, last], ...], ...}. The ranges are
+// kept as one vector of (run, first, last) sorted and merged, so that
+// accept() is a binary search.
+//
+
+#include <string>
+#include <vector>
+
+class EcalPhiSymLumiMask {
+
+ public:
+
+  EcalPhiSymLumiMask() : active_(false) {}
+
+  /// read fileName, false and an error message if it can't be parsed,
+  /// in which case all lumi sections are rejected
+  bool load(const std::string& fileName);
+
+  /// a mask is loaded
+  bool active() const { return active_; }
+
+  bool accept(unsigned int run, unsigned int lumi) const;
+
+  unsigned int size() const { return ranges_.size(); }
+
+ private:
+
+  struct Range {
+    unsigned int run;
+    unsigned int first;
+    unsigned int last;
+    bool operator<(const Range& other) const {
+      return run!=other.run ? run<other.run : first<other.first;
+    }
+  };
+
+  bool active_;
+  std::vector<Range> ranges_;
+
+};
+
+
+#endif
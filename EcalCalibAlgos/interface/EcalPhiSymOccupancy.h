@@ -0,0 +1,74 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymOccupancy_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymOccupancy_h_
+
+//
+// Hot and dead crystals flagged at the end of each lumi section, from
+// the hits the lumi section added to the main sums. A good crystal is
+// flagged hot (dead) when its hits are more than nSigma Poisson
+// deviations above (below) the mean of the other good crystals of its
+// tower, and of its ring. A tower is flagged, with all its crystals,
+// when its hits deviate as much from the means of its crystals' rings.
+// Means below minHits flag nothing, so short lumi sections are quiet.
+//
+// Flags last for the rest of the job and flagged crystals leave the
+// means. Each new flag is printed as a PHIFLAG line; with exclude,
+// applyFlags raises the status code of the flagged crystals to
+// flagStatus so that step2 masks them.
+//
+
+#include <vector>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymTowerIndex.h"
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+
+class EcalPhiSymAccumulator;
+class EcalPhiSymCrystalTable;
+
+class EcalPhiSymOccupancy {
+
+ public:
+
+  enum Flag { kNone=0, kHot=1, kDead=2 };
+
+  EcalPhiSymOccupancy();
+
+  /// inactive unless nSigma is positive
+  void configure(double nSigma, double minHits, bool exclude, int flagStatus);
+
+  bool active() const { return nSigma_>0.; }
+  bool exclude() const { return exclude_; }
+
+  /// hits of sums not to be counted in the next lumi section, e.g.
+  /// those of a checkpoint
+  void setBaseline(const EcalPhiSymAccumulator& sums);
+
+  /// flag from the hits added to sums since the last call; returns the
+  /// number of crystals newly flagged
+  int check(const edm::LuminosityBlock& lb, const EcalPhiSymAccumulator& sums,
+	    const EcalPhiSymCrystalTable& crystals);
+
+  /// with exclude, raise the status code of the flagged crystals
+  void applyFlags(EcalPhiSymAccumulator& sums) const;
+
+ private:
+
+  /// flag of n hits against a mean of at least minHits
+  Flag test(double n, double mean) const;
+
+  EcalPhiSymTowerIndex towers_;
+
+  double nSigma_;
+  double minHits_;
+  bool exclude_;
+  int flagStatus_;
+
+  /// hits of sums at the last check and flags, barrel hashed indices
+  /// then endcap ones
+  std::vector<unsigned int> last_;
+  std::vector<unsigned char> flag_;
+
+};
+
+
+#endif
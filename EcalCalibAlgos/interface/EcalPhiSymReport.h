@@ -0,0 +1,109 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymReport_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymReport_h_
+
+//
+// Per-lumi section and per-run step1 report, one JSON object per line
+// for the monitoring, e.g.
+//
+//   {"type":"lumi","run":251168,"lumi":12,"start":1435000000,"end":1435000023,
+//    "dur":23,"events":5120,"passed":5119,"skipped":0,"resumed":0,
+//    "hitsEB":12042311,"selectedEB":8100245,"hitsEE":9731002,"selectedEE":4420563,
+//    "wall":3.2,"cpu":3.1,"hitsPerSec":6.8e+06,"memory":52428800}
+//
+// Every lumi section is reported, short ones included. Times are those
+// spent in the module's event method, summed over streams; memory is
+// the size of the accumulated sums in bytes. Lines are appended, so a
+// job resumed from a checkpoint continues the report.
+//
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <time.h>
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+
+namespace phisym {
+
+  /// event and hit counts and times of a lumi section or run
+  struct ReportCounts {
+
+    ReportCounts() :
+      events(0), passed(0), skipped(0), resumed(0),
+      hits_barl(0), selected_barl(0), hits_endc(0), selected_endc(0),
+      wall(0.), cpu(0.) {}
+
+    void add(const ReportCounts& other);
+
+    /// events seen, with a selected hit, of masked lumi sections and
+    /// of lumi sections of the checkpoint the job resumed from
+    unsigned long long events;
+    unsigned long long passed;
+    unsigned long long skipped;
+    unsigned long long resumed;
+
+    /// hits examined and selected by the main cuts
+    unsigned long long hits_barl;
+    unsigned long long selected_barl;
+    unsigned long long hits_endc;
+    unsigned long long selected_endc;
+
+    /// seconds
+    double wall;
+    double cpu;
+  };
+
+  /// adds the wall and thread CPU time of its scope to counts
+  class ReportTimer {
+  public:
+    explicit ReportTimer(ReportCounts& counts) : counts_(counts) {
+      clock_gettime(CLOCK_MONOTONIC, &wall_);
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_);
+    }
+    ~ReportTimer() {
+      timespec wall, cpu;
+      clock_gettime(CLOCK_MONOTONIC, &wall);
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+      counts_.wall += seconds(wall_, wall);
+      counts_.cpu  += seconds(cpu_, cpu);
+    }
+  private:
+    static double seconds(const timespec& a, const timespec& b) {
+      return (b.tv_sec-a.tv_sec) + 1e-9*(b.tv_nsec-a.tv_nsec);
+    }
+    ReportCounts& counts_;
+    timespec wall_;
+    timespec cpu_;
+  };
+
+}
+
+
+class EcalPhiSymReport {
+
+ public:
+
+  /// report to fileName, created at the first line; inactive with an
+  /// empty fileName
+  void configure(const std::string& fileName) { fileName_ = fileName; }
+
+  bool active() const { return !fileName_.empty(); }
+
+  void writeLumi(const edm::LuminosityBlock& lb, const phisym::ReportCounts& counts,
+		 size_t memory);
+  void writeRun(const edm::Run& run, const phisym::ReportCounts& counts,
+		size_t memory);
+
+ private:
+
+  void write(const char* type, unsigned int run, unsigned int lumi,
+	     unsigned long long start, unsigned long long end,
+	     const phisym::ReportCounts& counts, size_t memory);
+
+  std::string fileName_;
+  std::ofstream out_;
+
+};
+
+
+#endif
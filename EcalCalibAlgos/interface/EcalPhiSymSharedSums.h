@@ -0,0 +1,130 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymSharedSums_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymSharedSums_h_
+
+//
+// Main step1 sums of all the processes of a node in one POSIX shared
+// memory segment, so that they write one etsum_barl_N.dat and
+// etsum_endc_N.dat between them instead of one each to be merged.
+//
+// Each process adds what its sums gained since its last merge, at the
+// end of every lumi section and of the job, with atomic adds: integer
+// keV in fixed-point mode, compare-and-swap on the doubles otherwise,
+// max of the status codes. The last of the expected number of processes
+// to detach gets the node totals to write and removes the segment; the
+// number is required, a process can't tell whether others will attach.
+// phisymShared shows the totals while the jobs run and writes them if a
+// job died.
+//
+// Layout: Header, then per crystal, barrel hashed indices then endcap
+// ones, ET sums, keV sums, E, ET^2 and E^2 sums, hits, endcap rings
+// and status codes. In fixed-point mode the E, ET^2 and E^2 columns
+// hold the integer sums of EcalPhiSymAccumulator instead of doubles.
+// New segments are zero filled, sums start empty.
+//
+
+#include <stdint.h>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class EcalPhiSymAccumulator;
+
+class EcalPhiSymSharedSums {
+
+ public:
+
+  static const uint32_t kVersion = 2;
+
+  struct Header {
+    uint32_t magic;       // 0 until the first process has set it up
+    uint32_t version;
+    uint32_t nbarl;
+    uint32_t nendc;
+    uint32_t fixedPoint;
+    uint32_t hasRings;
+    uint32_t expected;    // processes sharing the segment
+    uint32_t attached;
+    uint32_t detached;
+    uint32_t reserved;
+    uint64_t merges;
+    int64_t  lastMerge;   // time of the last merge
+  };
+
+  EcalPhiSymSharedSums();
+  ~EcalPhiSymSharedSums();
+
+  /// attach to the segment name ("/phisym_node", say), created if
+  /// needed, as one of expected processes; false if expected is 0, if
+  /// it can't be mapped or was created with another fixed-point mode or
+  /// number of processes. readOnly does not count as a process and
+  /// needs no expected
+  bool attach(const std::string& name, bool fixedPoint, unsigned int expected=0,
+	      bool readOnly=false);
+
+  bool active() const { return header_!=0; }
+  const Header& header() const { return *header_; }
+
+  /// endcap rings of the crystal table, kept for phisymShared
+  void setRings(const std::vector<short>& ring_endc);
+
+  /// add what sums gained since the last merge
+  void merge(const EcalPhiSymAccumulator& sums);
+
+  /// merge and detach; true for the last process, sums then holding
+  /// the node totals and the segment removed
+  bool detach(EcalPhiSymAccumulator& sums);
+
+  /// the node totals, with the endcap rings and good cells from
+  /// statusThreshold if the rings were kept
+  void load(EcalPhiSymAccumulator& sums, int statusThreshold) const;
+
+  /// processes, merges and hits of the node
+  void print(std::ostream& out) const;
+
+  static bool remove(const std::string& name);
+
+ private:
+
+  /// owns the mapping
+  EcalPhiSymSharedSums(const EcalPhiSymSharedSums&);
+  EcalPhiSymSharedSums& operator=(const EcalPhiSymSharedSums&);
+
+  static size_t size(uint32_t nbarl, uint32_t nendc);
+
+  /// per crystal columns in the segment
+  void map(char* base);
+
+  void unmap();
+
+  std::string name_;
+  Header* header_;
+  size_t size_;
+
+  double*        etsum_;
+  int64_t*       etsumKeV_;
+  double*        esum_;
+  double*        et2sum_;
+  double*        e2sum_;
+  int64_t*       esumKeV_;    // the same columns, fixed-point mode
+  int64_t*       et2sumKeV_;
+  int64_t*       e2sumKeV_;
+  uint32_t*      nhits_;
+  int16_t*       ring_endc_;
+  unsigned char* status_;
+
+  /// sums at the last merge, barrel then endcap
+  std::vector<double>       lastEtsum_;
+  std::vector<long long>    lastEtsumKeV_;
+  std::vector<double>       lastEsum_;
+  std::vector<double>       lastEt2sum_;
+  std::vector<double>       lastE2sum_;
+  std::vector<long long>    lastEsumKeV_;
+  std::vector<long long>    lastEt2sumKeV_;
+  std::vector<long long>    lastE2sumKeV_;
+  std::vector<unsigned int> lastNhits_;
+
+};
+
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymSpectra_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymSpectra_h_
+
+//
+// ET and E spectra per eta ring and side, as plain bin counts with the
+// binning of the ROOT histograms they are written to (bin 0 underflow,
+// bin nbins+1 overflow). Filling is an index computation and an
+// increment; copies are merged by adding the counts, and the ROOT
+// files written by write() can be merged with hadd.
+//
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+
+class EcalPhiSymSpectra {
+
+ public:
+
+  // binning in MeV
+  static const int kBinsBarl = 50;
+  static const int kBinsEndc = 75;
+  static const double kMaxBarl;
+  static const double kMaxEndc;
+
+  /// allocate the bins, spectra are not filled before
+  void book();
+  bool booked() const { return !et_barl_.empty(); }
+
+  void reset();
+  void add(const EcalPhiSymSpectra& other);
+
+  /// binary dump of the counts for a checkpoint
+  void writeState(std::ostream& out) const;
+  bool readState(std::istream& in);
+
+  /// bytes allocated for the counts
+  size_t memory() const {
+    return (et_barl_.capacity() + e_barl_.capacity() +
+	    et_endc_.capacity() + e_endc_.capacity())*sizeof(unsigned long long);
+  }
+
+  /// et and e in GeV
+  void fillBarl(int ieta, int sign, double et, double e) {
+    int offset = (ieta*kSides+sign)*(kBinsBarl+2);
+    et_barl_[offset+bin(et*1000., kBinsBarl, kMaxBarl)]++;
+    e_barl_ [offset+bin(e *1000., kBinsBarl, kMaxBarl)]++;
+  }
+  void fillEndc(int ring, int sign, double et, double e) {
+    int offset = (ring*kSides+sign)*(kBinsEndc+2);
+    et_endc_[offset+bin(et*1000., kBinsEndc, kMaxEndc)]++;
+    e_endc_ [offset+bin(e *1000., kBinsEndc, kMaxEndc)]++;
+  }
+
+  /// write one histogram per spectrum, ring and side, named e.g.
+  /// et_spectrum_b_<ring>_<sign>, ring counting from 1
+  void write(const std::string& fileName) const;
+
+ private:
+
+  /// same bin as TH1::Fill for an axis [0,max)
+  static int bin(double x, int nbins, double max) {
+    if (x < 0.)      return 0;
+    if (!(x < max))  return nbins+1;
+    return int(nbins*x/max)+1;
+  }
+
+  std::vector<unsigned long long> et_barl_;
+  std::vector<unsigned long long> e_barl_;
+  std::vector<unsigned long long> et_endc_;
+  std::vector<unsigned long long> e_endc_;
+
+};
+
+
+#endif
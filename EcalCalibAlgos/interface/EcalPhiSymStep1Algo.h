@@ -0,0 +1,312 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymStep1Algo_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymStep1Algo_h_
+
+//
+// The step1 hit selection and end-of-job output, independent of the
+// framework module that runs it. The selection only reads the algo,
+// so one instance can serve several streams, each filling its own
+// EcalPhiSymStep1Sums.
+//
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCheckpoint.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConstants.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymEventBins.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHelperSource.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitCache.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymLumiMask.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymOccupancy.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymReport.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymSharedSums.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Sums.h"
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+
+class EcalPhiSymLumiSums;
+
+class EcalPhiSymStep1Algo {
+
+ public:
+
+  static const int  kNMiscalBinsEB = EcalPhiSymStep1Sums::kNMiscalBinsEB;
+  static const float  kMiscalRangeEB;
+
+  static const int  kNMiscalBinsEE = EcalPhiSymStep1Sums::kNMiscalBinsEE; 
+  static const float  kMiscalRangeEE;
+
+  /// forceFixedPoint: integer sums whatever fixedPointSums, for the
+  /// modules whose sums must not depend on the order they are added in
+  explicit EcalPhiSymStep1Algo(const edm::ParameterSet& iConfig, bool forceFixedPoint=false);
+
+  /// geometry, channel status and previous constants, at the first
+  /// run; at the next ones the helper and crystal tables again if the
+  /// geometry or channel status changed
+  void setUp(const edm::EventSetup& setup);
+
+  /// the same from a crystal table and previous constants given by the
+  /// caller, for tools run without an EventSetup (phisymBatchBench);
+  /// threshold sets take their cuts on its eta columns, the hit cache
+  /// is not set up
+  void setUp(const EcalPhiSymCrystalTable& crystals, const EcalPhiSymConstants& oldCalibs);
+
+  int  eventSet() const { return eventSet_; }
+  unsigned int nThresholdSets() const { return thresholdSets_.size(); }
+  int  nSubsets() const { return nSubsets_; }
+
+  /// additional rechit collections, each accumulated with the main cuts
+  /// into its own sums
+  struct HitCollection {
+    std::string label;
+    std::string producer;
+    std::string barrelHits;
+    std::string endcapHits;
+  };
+  const std::vector<HitCollection>& hitCollections() const { return hitCollections_; }
+
+  /// event in a certified lumi section, always true without lumiMask
+  bool certifiedLumi(const edm::EventID& id) const {
+    return lumiMask_.accept(id.run(), id.luminosityBlock());
+  }
+
+  /// event in a lumi section of the checkpoint the job resumed from,
+  /// already in the sums
+  bool resumedLumi(const edm::EventID& id) const {
+    return checkpoint_.resumed(id.run(), id.luminosityBlock());
+  }
+
+  /// JSON lines report, inactive without reportFile
+  EcalPhiSymReport& report() { return report_; }
+
+  /// periodic checkpoint of the sums, inactive without checkpoint
+  EcalPhiSymCheckpoint& checkpoint() { return checkpoint_; }
+
+  /// add the sums of the checkpoint, if there is one, to booked sums;
+  /// the events of its lumi sections are then skipped
+  void resume(EcalPhiSymStep1Sums& sums);
+
+  /// event subset from a hash of (run, lumi, event), -1 if the job
+  /// does not split events
+  int subset(const edm::EventID& id) const;
+
+  /// sums of the event's bin, created if needed; 0 if the job does not
+  /// bin events or if the key was not admitted. Keys are admitted once
+  /// per job, up to maxBins, so the streams all bin the same keys
+  EcalPhiSymStep1Sums::Bin* bin(const edm::Event& event,
+				EcalPhiSymStep1Sums& sums) const;
+  bool spectra()  const { return spectra_; }
+
+  /// write the hits in the cache window to a hit cache
+  bool hitCache() const { return hitCache_; }
+
+  /// open hitcache_N.bin, or hitcache_N_<stream>.bin if stream>=0
+  bool openHitCache(EcalPhiSymHitCache& cache, int stream=-1) const;
+
+  /// write the event's hits in the cache window, uncalibrated
+  void cacheHits(const EBRecHitCollection& barrelRecHits,
+		 const EERecHitCollection& endcapRecHits,
+		 const edm::EventID& id, EcalPhiSymHitCache& cache) const;
+
+  /// prepare sums for this configuration (fixed point, spectra) and
+  /// zero them
+  void book(EcalPhiSymStep1Sums& sums) const;
+
+  /// select and accumulate the hits of one event into sums, into the
+  /// sums of its subset if not -1 and into binSums if given; returns
+  /// true if any hit was selected
+  bool accumulate(const EBRecHitCollection& barrelRecHits,
+		  const EERecHitCollection& endcapRecHits,
+		  EcalPhiSymStep1Sums& sums, int subset=-1,
+		  EcalPhiSymAccumulator* binSums=0) const {
+    return (this->*accumulateHits_)(barrelRecHits, endcapRecHits, sums,
+				    subset, binSums);
+  }
+
+  /// the ET sums only, for the additional hit collections
+  bool accumulateSums(const EBRecHitCollection& barrelRecHits,
+		      const EERecHitCollection& endcapRecHits,
+		      EcalPhiSymAccumulator& sums) const;
+
+  /// write spectra, k factors and ET sums of the job. The ET sums of
+  /// threshold sets, hit collections, event subsets and event bins go
+  /// to the same files prefixed by <label>_, sub<k>_ and <bin label>_;
+  /// bins_N.dat lists the bins with their events
+  void endJob(EcalPhiSymStep1Sums& sums);
+
+  /// move the lumi section sums to the product, with the job's status
+  /// codes, and zero them
+  void lumiProduct(EcalPhiSymStep1Sums& sums, EcalPhiSymLumiSums& product) const;
+
+  /// PHIREPRT/PHILB summary lines, nskipped being the events of lumi
+  /// sections not in the mask and nresumed those of lumi sections of
+  /// the checkpoint; lumi sections shorter than 60 s are not
+  /// reported and reportLumi returns false. See report() for all of
+  /// them, with hit counts and times
+  static void reportRun(const edm::Run& run, unsigned int npass,
+			unsigned int nskipped=0, unsigned int nresumed=0);
+  static bool reportLumi(const edm::LuminosityBlock& lb, unsigned int npass);
+
+  /// PHICONV line with the per-ring convergence of the sums, after the
+  /// PHILB line; with stopAtPrecision the job is ended gracefully once
+  /// every ring reaches targetPrecision
+  bool trackConvergence() const { return trackConvergence_; }
+  void reportConvergence(const edm::LuminosityBlock& lb,
+			 const EcalPhiSymAccumulator& sums) const;
+
+  /// hot and dead crystals flagged at the end of each lumi section from
+  /// the hits added to sums since the last one, see EcalPhiSymOccupancy
+  bool flagHotDead() const { return occupancy_.active(); }
+  void checkOccupancy(const edm::LuminosityBlock& lb, const EcalPhiSymAccumulator& sums);
+
+  /// with excludeHotDead, raise the status code of the flagged crystals
+  /// in all sums, before they are written
+  void applyFlags(EcalPhiSymStep1Sums& sums) const;
+
+  /// main sums shared by the processes of the node, see
+  /// EcalPhiSymSharedSums; merged at the end of each lumi section and
+  /// written by endJob of the last process only
+  bool sharedSums() const { return shared_.active(); }
+  void mergeShared(const EcalPhiSymAccumulator& sums) { shared_.merge(sums); }
+
+  /// add q, the ET of the hit or its integer keV, to etdiff over the
+  /// miscalibration bins in which the hit passes the cuts
+  template <class T>
+  static void fillMiscal(const double* miscal, int nbins, float e, float et,
+			 float eCut, float et_thr, T q, T* etdiff);
+
+ private:
+
+  /// hit loop for one combination of reiteration, k-factor scan
+  /// (eventSet 1) and spectra
+  template <bool Reiterate, bool KScan, bool Spectra>
+  bool accumulateHits(const EBRecHitCollection& barrelRecHits,
+		      const EERecHitCollection& endcapRecHits,
+		      EcalPhiSymStep1Sums& sums, int subset,
+		      EcalPhiSymAccumulator* binSums) const;
+
+  void getKfactors(const EcalPhiSymStep1Sums& sums);
+
+
+  EcalGeomPhiSymHelper e_; 
+  EcalPhiSymHelperSource helperSource_;
+
+  /// worst status code of each crystal over the channel status IOVs of
+  /// the job, by hashed index, merged into the sums written
+  std::vector<unsigned char> jobStatus_barl_;
+  std::vector<unsigned char> jobStatus_endc_;
+
+  /// endcap rings and status codes of the helper into sums
+  void setupSums(EcalPhiSymAccumulator& sums) const;
+
+  /// per-crystal cuts and 1/cosh(eta), indexed by hashed DetId
+  EcalPhiSymCrystalTable crystals_;
+
+  // ET sums per ring for each miscalibration, derived at end of job
+  double etsum_barl_miscal_[kNMiscalBinsEB][kBarlRings]   [kSides];
+  double etsum_endc_miscal_[kNMiscalBinsEE][kEndcEtaRings][kSides];
+
+  // factors to convert from ET sum deviation to miscalibration
+  double k_barl_[kBarlRings]   [kSides];
+  double k_endc_[kEndcEtaRings][kSides];
+  double miscalEB_[kNMiscalBinsEB];
+  double miscalEE_[kNMiscalBinsEE]; 
+
+  // energy cut in the barrel
+  double eCut_barl_;
+  
+
+  // parametrized energy cut EE : e_cut = ap + eta_ring*b
+  double ap_;
+  double b_;
+
+  /// additional cuts accumulated on the same calibrated hits, to
+  /// compare thresholds without running over the data again
+  struct ThresholdSet {
+    std::string label;
+    double eCut_barl;
+    double ap;
+    double b;
+    EcalPhiSymCrystalTable crystals;
+  };
+  std::vector<ThresholdSet> thresholdSets_;
+
+  std::vector<HitCollection> hitCollections_;
+
+  /// number of event subsets for the precision estimate in step2,
+  /// 0 to not split
+  int nSubsets_;
+
+  /// certified lumi sections, inactive without lumiMask
+  EcalPhiSymLumiMask lumiMask_;
+
+  EcalPhiSymReport report_;
+
+  EcalPhiSymOccupancy occupancy_;
+
+  EcalPhiSymSharedSums shared_;
+
+  /// sums written every checkpointLumis lumi sections or
+  /// checkpointSeconds, and the lumi sections they contain
+  EcalPhiSymCheckpoint checkpoint_;
+
+  /// event binning, inactive if no key is configured
+  EcalPhiSymEventBins bins_;
+  /// keys admitted by any stream, and the lock the streams share
+  mutable std::set<unsigned int> binKeys_;
+  mutable std::mutex binMutex_;
+
+  int eventSet_;
+  /// threshold in channel status beyond which channel is marked bad
+  int statusThreshold_; 
+
+  /// accumulate bad channels too, their status code is written with
+  /// the sums and step2 masks them; the k-factor scan uses good ones
+  bool allChannels_;
+
+  bool reiteration_;
+  std::string oldcalibfile_; //searched for in Calibration/EcalCalibAlgos/data
+  
+  /// the old calibration constants (when reiterating, the last ones derived)
+  EcalPhiSymConstants oldCalibs_;
+
+  bool spectra_;
+  std::string spectraFile_;
+
+  /// sum ET as integer keV, see EcalPhiSymAccumulator
+  bool fixedPoint_;
+
+  /// per-crystal ET histograms for step2, written to ehisto_N.dat
+  bool energyHistos_;
+  int energyHistoBins_;
+  std::vector<double> energyHistoRangeEB_;
+  std::vector<double> energyHistoRangeEE_;
+
+  /// hit cache for replays, window as fractions of eCut and etThr
+  bool hitCache_;
+  std::vector<double> hitCacheWindow_;
+  EcalPhiSymCrystalTable cacheCrystals_;
+
+  /// expected precision of the crystal ET sums, see EcalPhiSymConvergence
+  bool trackConvergence_;
+  double targetPrecision_;
+  bool stopAtPrecision_;
+
+  bool isSetUp_;
+
+  /// accumulateHits specialization for the job's modes
+  bool (EcalPhiSymStep1Algo::*accumulateHits_)(const EBRecHitCollection&,
+					       const EERecHitCollection&,
+					       EcalPhiSymStep1Sums&, int,
+					       EcalPhiSymAccumulator*) const;
+
+};
+
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymStep1Sums_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymStep1Sums_h_
+
+//
+// Everything step1 accumulates from the hits: per-crystal ET sums, the
+// miscalibration scan and the ET/E spectra. One copy is filled per
+// stream and the copies are added at the end of the job.
+//
+
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymEnergyHistos.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymReport.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymSpectra.h"
+
+class EcalPhiSymStep1Sums {
+
+ public:
+
+  static const int kNMiscalBinsEB = 21;
+  static const int kNMiscalBinsEE = 41;
+
+  EcalPhiSymStep1Sums();
+
+  /// zero all sums
+  void reset();
+
+  /// add the sums of another copy
+  void add(const EcalPhiSymStep1Sums& other);
+
+  /// binary dump of everything but the lumi section sums, for a
+  /// checkpoint; readState() fails unless this copy was booked by the
+  /// configuration that wrote it
+  void writeState(std::ostream& out) const;
+  bool readState(std::istream& in);
+
+  /// bytes allocated for all the sums
+  size_t memory() const;
+
+
+  /// per-crystal ET sums and hit counts
+  EcalPhiSymAccumulator sums_;
+
+  /// the same for each additional threshold set of the algo
+  std::vector<EcalPhiSymAccumulator> thresholdSums_;
+
+  /// per-crystal sums of each additional hit collection of the algo
+  std::vector<EcalPhiSymAccumulator> collectionSums_;
+
+  /// per-crystal sums of each event subset, main cuts only
+  std::vector<EcalPhiSymAccumulator> subsetSums_;
+
+  /// sums of the events of one bin, see EcalPhiSymEventBins
+  struct Bin {
+    Bin() : nevents(0) {}
+    EcalPhiSymAccumulator sums;
+    unsigned int nevents;
+  };
+
+  /// bins by key, created at the first event of each
+  std::map<unsigned int, Bin> bins_;
+
+  /// events not binned because the maximum number of bins was reached
+  unsigned int unbinned_;
+
+  // a hit passes the cuts for a contiguous range of miscalibration bins:
+  // its ET is added at the first bin and subtracted past the last one,
+  // the running sum over bins gives the unmiscalibrated ET sum per bin
+  double etdiff_barl_miscal_[kBarlRings]   [kSides][kNMiscalBinsEB+1];
+  double etdiff_endc_miscal_[kEndcEtaRings][kSides][kNMiscalBinsEE+1];
+
+  /// the same in integer keV, filled instead in fixed-point mode
+  long long etdiffKeV_barl_miscal_[kBarlRings]   [kSides][kNMiscalBinsEB+1];
+  long long etdiffKeV_endc_miscal_[kEndcEtaRings][kSides][kNMiscalBinsEE+1];
+
+  /// Et and E spectra, filled if booked
+  EcalPhiSymSpectra spectra_;
+
+  /// per-crystal uncalibrated ET histograms, filled if booked
+  EcalPhiSymEnergyHistos energyHistos_;
+
+  /// events with at least one selected hit
+  unsigned int nevents_;
+
+  /// counts and times since the last report, zeroed by the module at
+  /// the end of each lumi section; not added by add() nor checkpointed
+  phisym::ReportCounts report_;
+
+  /// main sums of the current lumi section, filled if fillLumiSums_
+  /// (PhiSymmetryCalibrationProducer), and its events
+  bool fillLumiSums_;
+  EcalPhiSymAccumulator lumiSums_;
+  unsigned int lumiEvents_;
+
+};
+
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _Calibration_EcalCalibAlgos_EcalPhiSymTowerIndex_h_
+#define _Calibration_EcalCalibAlgos_EcalPhiSymTowerIndex_h_
+
+//
+// Crystal to tower and tower to crystals, by hashed DetId. Towers are
+// the 5x5 blocks of the step2 tower selection: barrel trigger towers
+// (5 ieta x 5 iphi from ieta 1, iphi 1 on each side) and endcap
+// supercrystals (5 ix x 5 iy from ix 1, iy 1 on each side). Barrel
+// towers come first, endcap blocks without crystals are left out.
+//
+// Built from the DetId numbering alone, no geometry needed.
+//
+
+#include <vector>
+
+class EcalPhiSymTowerIndex {
+
+ public:
+
+  static const int kBarlTowersEta = 17;
+  static const int kBarlTowersPhi = 72;
+  static const int kEndcTowersX   = 20;
+  static const int kEndcTowersY   = 20;
+
+  EcalPhiSymTowerIndex();
+
+  int nTowers() const { return offsets_.size()-1; }
+  int nBarlTowers() const { return nBarlTowers_; }
+  bool isBarl(int tower) const { return tower < nBarlTowers_; }
+
+  /// tower of a crystal
+  int towerBarl(int hi) const { return tower_barl_[hi]; }
+  int towerEndc(int hi) const { return tower_endc_[hi]; }
+
+  /// hashed indices of the crystals of a tower, barrel or endcap
+  /// according to isBarl()
+  const int* begin(int tower) const { return &cells_[0]+offsets_[tower]; }
+  const int* end(int tower)   const { return &cells_[0]+offsets_[tower+1]; }
+  int size(int tower) const { return offsets_[tower+1]-offsets_[tower]; }
+
+ private:
+
+  int nBarlTowers_;
+
+  std::vector<int> tower_barl_;
+  std::vector<int> tower_endc_;
+
+  /// crystals of tower t in cells_[offsets_[t], offsets_[t+1])
+  std::vector<int> offsets_;
+  std::vector<int> cells_;
+
+};
+
+
+#endif
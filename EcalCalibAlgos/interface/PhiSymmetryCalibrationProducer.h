@@ -0,0 +1,68 @@
+#ifndef Calibration_EcalCalibAlgos_PhiSymmetryCalibrationProducer_h
+#define Calibration_EcalCalibAlgos_PhiSymmetryCalibrationProducer_h
+
+//
+// Package:    Calibration/EcalCalibAlgos
+// Class:      PhiSymmetryCalibrationProducer
+// 
+//
+// Description: phi-symmetry calibration step1 in producer mode. Same
+//              configuration and end-of-job output as
+//              PhiSymmetryCalibration; in addition the main sums of
+//              each lumi section are put in the LuminosityBlock as an
+//              EcalPhiSymLumiSums, to be written to EDM files, merged
+//              and read by step2 with any lumi section selection.
+//
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Algo.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Sums.h"
+
+// Framework
+#include "FWCore/Framework/interface/one/EDProducer.h"
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+
+
+class PhiSymmetryCalibrationProducer :
+  public edm::one::EDProducer<edm::EndLuminosityBlockProducer,
+			      edm::one::WatchRuns>
+{
+
+ public:
+
+  explicit PhiSymmetryCalibrationProducer(const edm::ParameterSet& iConfig);
+
+  virtual void beginJob();
+  virtual void endJob();
+
+  virtual void produce(edm::Event&, const edm::EventSetup&);
+
+  virtual void beginRun(const edm::Run&, const edm::EventSetup&);
+  virtual void endRun(const edm::Run&, const edm::EventSetup&);
+
+  virtual void endLuminosityBlockProduce(edm::LuminosityBlock&, const edm::EventSetup&);
+
+ private:
+
+  EcalPhiSymStep1Algo algo_;
+
+  /// everything accumulated from the hits, and the lumi section sums
+  EcalPhiSymStep1Sums sums_;
+
+  /// hits in the cache window, if hitCache is set
+  EcalPhiSymHitCache cache_;
+
+  std::string ecalHitsProducer_;
+  std::string barrelHits_;
+  std::string endcapHits_;
+
+  bool isfirstpass_;
+
+  unsigned int eventsinrun_;
+  unsigned int skippedinrun_;
+  unsigned int eventsinlb_;
+
+  /// report counts of the run, from those of its lumi sections
+  phisym::ReportCounts runReport_;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef Calibration_EcalCalibAlgos_PhiSymmetryCalibrationStream_h
+#define Calibration_EcalCalibAlgos_PhiSymmetryCalibrationStream_h
+
+//
+// Package:    Calibration/EcalCalibAlgos
+// Class:      PhiSymmetryCalibrationStream
+// 
+//
+// Description: multi-threaded phi-symmetry calibration step1.
+//              Same configuration and output as PhiSymmetryCalibration;
+//              each stream fills its own sums, which are added at the
+//              end of the job. The sums are always in fixed point
+//              (fixedPointSums), so that they do not depend on which
+//              stream got which event: the files are the same as those
+//              of PhiSymmetryCalibration with fixedPointSums. Events
+//              passing the selection are counted per lumi section and
+//              per run in summaries. Checkpoints are written at the end of
+//              lumi sections, from the sums of all streams.
+//
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Algo.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Sums.h"
+
+// Framework
+#include "FWCore/Framework/interface/stream/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Utilities/interface/StreamID.h"
+
+
+namespace phisym {
+
+  /// shared by all streams
+  struct Step1Global {
+
+    explicit Step1Global(const edm::ParameterSet& iConfig) :
+      algo(iConfig, true), resumed(new EcalPhiSymStep1Sums), lumiCarry(0), memory(0) {}
+
+    /// set up at the beginning of each run, before the streams see
+    /// its events
+    mutable EcalPhiSymStep1Algo algo;
+
+    mutable std::mutex mutex;
+    /// sums of the checkpoint the job resumed from, if any
+    std::unique_ptr<EcalPhiSymStep1Sums> resumed;
+    /// sums of each stream, filled at end of stream
+    mutable std::map<unsigned int, std::unique_ptr<EcalPhiSymStep1Sums> > streamSums;
+    /// events of lumi sections too short to be reported
+    mutable unsigned int lumiCarry;
+    /// report counts of the run, from those of its lumi sections, and
+    /// the memory of the stream sums at the last one
+    mutable phisym::ReportCounts runReport;
+    mutable size_t memory;
+  };
+
+  /// events with a selected hit, and events of masked lumi sections,
+  /// in a run or lumi section; for the convergence report, the hot and
+  /// dead crystal flags and the shared sums, the sums of all streams at
+  /// the end of the lumi section, and everything they accumulated if a
+  /// checkpoint is due then; report counts and memory of all streams
+  struct Step1Count {
+    Step1Count() : npass(0), nskipped(0), nresumed(0), checkpoint(false), memory(0) {}
+    unsigned int npass;
+    unsigned int nskipped;
+    unsigned int nresumed;
+    std::unique_ptr<EcalPhiSymAccumulator> sums;
+    bool checkpoint;
+    std::unique_ptr<EcalPhiSymStep1Sums> state;
+    phisym::ReportCounts report;
+    size_t memory;
+  };
+
+}
+
+
+class PhiSymmetryCalibrationStream :
+  public edm::stream::EDAnalyzer<edm::GlobalCache<phisym::Step1Global>,
+				 edm::RunSummaryCache<phisym::Step1Count>,
+				 edm::LuminosityBlockSummaryCache<phisym::Step1Count> >
+{
+
+ public:
+
+  PhiSymmetryCalibrationStream(const edm::ParameterSet& iConfig,
+			       const phisym::Step1Global* global);
+
+  static std::unique_ptr<phisym::Step1Global> initializeGlobalCache(const edm::ParameterSet& iConfig);
+  static void globalEndJob(phisym::Step1Global* global);
+
+  virtual void beginStream(edm::StreamID id);
+  virtual void endStream();
+
+  virtual void analyze(const edm::Event&, const edm::EventSetup&);
+
+  virtual void beginRun(const edm::Run&, const edm::EventSetup&);
+  static std::shared_ptr<phisym::Step1Count>
+    globalBeginRunSummary(const edm::Run&, const edm::EventSetup&, const RunContext*);
+  void endRunSummary(const edm::Run&, const edm::EventSetup&, phisym::Step1Count*) const;
+  static void globalEndRunSummary(const edm::Run&, const edm::EventSetup&,
+				  const RunContext*, phisym::Step1Count*);
+
+  virtual void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&);
+  static std::shared_ptr<phisym::Step1Count>
+    globalBeginLuminosityBlockSummary(const edm::LuminosityBlock&, const edm::EventSetup&,
+				      const LuminosityBlockContext*);
+  void endLuminosityBlockSummary(const edm::LuminosityBlock&, const edm::EventSetup&,
+				 phisym::Step1Count*) const;
+  static void globalEndLuminosityBlockSummary(const edm::LuminosityBlock&, const edm::EventSetup&,
+					      const LuminosityBlockContext*, phisym::Step1Count*);
+
+ private:
+
+  std::string ecalHitsProducer_;
+  std::string barrelHits_;
+  std::string endcapHits_;
+
+  unsigned int streamId_;
+
+  /// this stream's sums, handed to the global cache at end of stream
+  std::unique_ptr<EcalPhiSymStep1Sums> sums_;
+
+  /// this stream's hit cache, hitcache_N_<stream>.bin
+  EcalPhiSymHitCache cache_;
+  bool cacheOpened_;
+
+  unsigned int eventsinrun_;
+  unsigned int skippedinrun_;
+  unsigned int resumedinrun_;
+  unsigned int eventsinlb_;
+};
+
+#endif
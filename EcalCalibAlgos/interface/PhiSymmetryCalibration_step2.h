@@ -3,12 +3,18 @@
 
 
 #include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConstants.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymEnergyHistos.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHelperSource.h"
 #include "CondFormats/EcalObjects/interface/EcalIntercalibConstants.h"
 #include "FWCore/Framework/interface/EDAnalyzer.h"
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "FWCore/Framework/interface/ProducerBase.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Utilities/interface/InputTag.h"
 
 class TH1F;
 class TH2F;
@@ -26,6 +32,12 @@ class PhiSymmetryCalibration_step2 :  public edm::EDAnalyzer
   
   void analyze( const edm::Event&, const edm::EventSetup& );
 
+  /// set up, or the good cells again if the channel status changed
+  void beginRun(const edm::Run&, const edm::EventSetup&);
+
+  /// add the EcalPhiSymLumiSums of the lumi section, if lumiSums is set
+  void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&);
+
   void fillHistos();
   void fillConstantsHistos();
   void setupResidHistos();
@@ -35,24 +47,26 @@ class PhiSymmetryCalibration_step2 :  public edm::EDAnalyzer
 
   void readEtSums();
 
+  /// constants of each step1 event subset and their spread per ring
+  void subsetPrecision();
+
+  /// iterate the constants on the step1 energy histograms, with the
+  /// cuts of this job
+  void iterateEnergyHistos();
+
  private:  
 
 
  
   
-  // Transverse energy sum arrays
-  double etsum_barl_[kBarlRings]  [kBarlWedges] [kSides];
-  double etsum_endc_[kEndcWedgesX][kEndcWedgesY][kSides];
-  double etsum_endc_uncorr[kEndcWedgesX][kEndcWedgesY][kSides];
+  /// per-crystal ET sums, hit counts and good-cell flags
+  EcalPhiSymAccumulator sums_;
+
+  // per-crystal arrays indexed by hashed DetId
+  std::vector<double> etsum_endc_uncorr;
+
   double etsumMean_barl_[kBarlRings][kSides];
   double etsumMean_endc_[kEndcEtaRings][kSides];
-   
-  unsigned int nhits_barl_[kBarlRings][kBarlWedges] [kSides];
-  unsigned int nhits_endc_[kEndcWedgesX][kEndcWedgesY][kSides];
-   
-   
-  double esum_barl_[kBarlRings]  [kBarlWedges] [kSides];
-  double esum_endc_[kEndcWedgesX][kEndcWedgesY][kSides];
 
   double esumMean_barl_[kBarlRings][kSides];
   double esumMean_endc_[kEndcEtaRings][kSides];
@@ -75,26 +89,63 @@ class PhiSymmetryCalibration_step2 :  public edm::EDAnalyzer
   float epsilon_M_endc[kEndcWedgesX][kEndcWedgesY][kSides];
 
   EcalGeomPhiSymHelper e_; 
+  EcalPhiSymHelperSource helperSource_;
 
   std::vector<DetId> barrelCells;
   std::vector<DetId> endcapCells;
 
+  /// not set up yet
   bool firstpass_;
   int statusThreshold_;
 
 
   bool reiteration_;
   std::string oldcalibfile_;
+
+  /// step1 sums are in integer keV
+  bool fixedPoint_;
+
+  /// label of the step1 threshold set to calibrate, empty for the
+  /// main cuts
+  std::string thresholdSet_;
+
+  /// step1 lumi section products to sum instead of the etsum files,
+  /// empty to read the files
+  edm::InputTag lumiSums_;
+
+  /// false if a step1 file had no ET^2 column, the errors of the
+  /// constants are then not written
+  bool et2Sums_;
+
+  /// labels of step1 event bins to combine, instead of the main sums
+  std::vector<std::string> bins_;
+
+  /// number of step1 event subsets, 0 if events were not split
+  int nSubsets_;
+
+  /// step1 energy histograms (ehisto.dat), the cuts to apply to them
+  /// and the iterations
+  bool energyHistos_;
+  EcalPhiSymEnergyHistos histos_;
+  EcalPhiSymCrystalTable crystals_;
+  double eCut_barl_;
+  double ap_;
+  double b_;
+  int histoIterations_;
+  double histoTolerance_;
   
   /// the old calibration constants (when reiterating, the last ones derived)
-  EcalIntercalibConstants oldCalibs_;
+  EcalPhiSymConstants oldCalibs_;
   
   /// calib constants that we are going to calculate
-  EcalIntercalibConstants newCalibs_;
+  EcalPhiSymConstants newCalibs_;
+
+  /// their statistical errors, from the ET^2 sums
+  EcalPhiSymConstants newErrors_;
   
   
   /// initial miscalibration applied if any)
-  EcalIntercalibConstants miscalib_;
+  EcalPhiSymConstants miscalib_;
 
   /// 
   bool have_initial_miscalib_;
@@ -1,6 +1,7 @@
 #include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
 
 #include "FWCore/Framework/interface/ESHandle.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
 
 
 // Geometry
@@ -20,6 +21,7 @@ void EcalGeomPhiSymHelper::setup(const CaloGeometry* geometry,
 				 const EcalChannelStatus* chStatus,
 				 int statusThresold){
 
+  statusThreshold_ = statusThresold;
   
   for (int ieta=0; ieta<kBarlRings; ieta++)    nBads_barl[ieta] = 0;
   for (int ring=0; ring<kEndcEtaRings; ring++) nBads_endc[ring] = 0;
@@ -30,6 +32,10 @@ void EcalGeomPhiSymHelper::setup(const CaloGeometry* geometry,
       cellPhi_[ix][iy]=0.;
       cellArea_[ix][iy]=0.;
       endcapRing_[ix][iy]=-1;
+      for (int sign=0; sign<kSides; sign++) {
+	goodCell_endc[ix][iy][sign]=false;
+	statusCode_endc[ix][iy][sign]=0;
+      }
     }
   }
  
@@ -44,8 +50,8 @@ void EcalGeomPhiSymHelper::setup(const CaloGeometry* geometry,
     int sign = eb.zside()>0 ? 1 : 0;
     
     int chs= (*chStatus)[*barrelIt].getStatusCode() & 0x001F;
-    if( chs <=  statusThresold)
-      goodCell_barl[abs(eb.ieta())-1][eb.iphi()-1][sign] = true;
+    statusCode_barl[abs(eb.ieta())-1][eb.iphi()-1][sign] = chs;
+    goodCell_barl[abs(eb.ieta())-1][eb.iphi()-1][sign] = chs <= statusThresold;
     	    
     if( !goodCell_barl[abs(eb.ieta())-1][eb.iphi()-1][sign] )
       nBads_barl[abs(eb.ieta())-1]++;
@@ -105,8 +111,8 @@ void EcalGeomPhiSymHelper::setup(const CaloGeometry* geometry,
     cellArea_[ix][iy] = deltaEta*deltaPhi;
 */
     int chs= (*chStatus)[*endcapIt].getStatusCode() & 0x001F;
-    if( chs <=  statusThresold)
-      goodCell_endc[ix][iy][sign] = true;
+    statusCode_endc[ix][iy][sign] = chs;
+    goodCell_endc[ix][iy][sign] = chs <= statusThresold;
     	    
 
   }
@@ -192,3 +198,31 @@ void EcalGeomPhiSymHelper::setup(const CaloGeometry* geometry,
               
     }
 }
+
+
+void EcalGeomPhiSymHelper::applyStatusThreshold(int statusThreshold){
+
+  statusThreshold_ = statusThreshold;
+
+  for (int ieta=0; ieta<kBarlRings; ieta++) {
+    nBads_barl[ieta] = 0;
+    for (int iphi=0; iphi<kBarlWedges; iphi++) {
+      for (int sign=0; sign<kSides; sign++) {
+	goodCell_barl[ieta][iphi][sign] = statusCode_barl[ieta][iphi][sign] <= statusThreshold;
+	if (!goodCell_barl[ieta][iphi][sign]) nBads_barl[ieta]++;
+      }
+    }
+  }
+
+  for (int ring=0; ring<kEndcEtaRings; ring++) nBads_endc[ring] = 0;
+  for (int ix=0; ix<kEndcWedgesX; ix++) {
+    for (int iy=0; iy<kEndcWedgesY; iy++) {
+      for (int sign=0; sign<kSides; sign++) {
+	goodCell_endc[ix][iy][sign] = EEDetId::validDetId(ix+1, iy+1, sign ? 1 : -1) &&
+	  statusCode_endc[ix][iy][sign] <= statusThreshold;
+	if (endcapRing_[ix][iy]!=-1 && !goodCell_endc[ix][iy][sign])
+	  nBads_endc[endcapRing_[ix][iy]]++;
+      }
+    }
+  }
+}
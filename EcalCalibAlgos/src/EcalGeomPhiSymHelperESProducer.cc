@@ -0,0 +1,32 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelperESProducer.h"
+
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/ModuleFactory.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+
+
+EcalGeomPhiSymHelperESProducer::EcalGeomPhiSymHelperESProducer(const edm::ParameterSet& iConfig) :
+  statusThreshold_(iConfig.getUntrackedParameter<int>("statusThreshold",3))
+{
+  setWhatProduced(this);
+}
+
+
+std::unique_ptr<EcalGeomPhiSymHelper>
+EcalGeomPhiSymHelperESProducer::produce(const EcalPhiSymHelperRcd& record){
+
+  edm::ESHandle<CaloGeometry> geoHandle;
+  record.getRecord<CaloGeometryRecord>().get(geoHandle);
+
+  edm::ESHandle<EcalChannelStatus> chStatus;
+  record.getRecord<EcalChannelStatusRcd>().get(chStatus);
+
+  std::unique_ptr<EcalGeomPhiSymHelper> helper(new EcalGeomPhiSymHelper);
+  helper->setup(&(*geoHandle), &(*chStatus), statusThreshold_);
+  return helper;
+}
+
+DEFINE_FWK_EVENTSETUP_MODULE(EcalGeomPhiSymHelperESProducer);
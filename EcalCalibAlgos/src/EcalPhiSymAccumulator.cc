@@ -0,0 +1,518 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCheckpoint.h"
+#include "PhiSym/EcalCalibDataFormats/interface/EcalPhiSymLumiSums.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+
+namespace {
+
+  // integer keV as GeV with exactly 6 decimals
+  std::string keVToString(long long q){
+    unsigned long long a = q<0 ? -(unsigned long long)q : q;
+    std::ostringstream s;
+    if (q<0) s << "-";
+    s << a/1000000 << "." << std::setw(6) << std::setfill('0') << a%1000000;
+    return s.str();
+  }
+
+}
+
+
+EcalPhiSymAccumulator::EcalPhiSymAccumulator() :
+  etsum_barl_   (EBDetId::kSizeForDenseIndexing, 0.),
+  nhits_barl_   (EBDetId::kSizeForDenseIndexing, 0),
+  goodCell_barl_(EBDetId::kSizeForDenseIndexing, false),
+  status_barl_  (EBDetId::kSizeForDenseIndexing, 0),
+  esum_barl_    (EBDetId::kSizeForDenseIndexing, 0.),
+  et2sum_barl_  (EBDetId::kSizeForDenseIndexing, 0.),
+  e2sum_barl_   (EBDetId::kSizeForDenseIndexing, 0.),
+  etsum_endc_   (EEDetId::kSizeForDenseIndexing, 0.),
+  nhits_endc_   (EEDetId::kSizeForDenseIndexing, 0),
+  goodCell_endc_(EEDetId::kSizeForDenseIndexing, false),
+  status_endc_  (EEDetId::kSizeForDenseIndexing, 0),
+  esum_endc_    (EEDetId::kSizeForDenseIndexing, 0.),
+  et2sum_endc_  (EEDetId::kSizeForDenseIndexing, 0.),
+  e2sum_endc_   (EEDetId::kSizeForDenseIndexing, 0.),
+  overflows_(0),
+  fixedPoint_(false),
+  endcIndex_    (kEndcWedgesX*kEndcWedgesY*kSides, -1),
+  endcRing_     (EEDetId::kSizeForDenseIndexing, -1),
+  endcRingOffsets_(kEndcEtaRings*kSides+1, 0)
+{
+  // the endcap grid -> hashed index map needs no geometry, so that
+  // sums can be read before the first event
+  for (int ix=0; ix<kEndcWedgesX; ix++) {
+    for (int iy=0; iy<kEndcWedgesY; iy++) {
+      for (int sign=0; sign<kSides; sign++) {
+	int thesign = sign==1 ? 1:-1;
+	if (EEDetId::validDetId(ix+1, iy+1, thesign))
+	  endcIndex_[(ix*kEndcWedgesY+iy)*kSides+sign] =
+	    EEDetId(ix+1, iy+1, thesign).hashedIndex();
+      }
+    }
+  }
+}
+
+
+void EcalPhiSymAccumulator::setup(const EcalGeomPhiSymHelper& helper){
+
+  for (int sign=0; sign<kSides; sign++) {
+    for (int ieta=0; ieta<kBarlRings; ieta++) {
+      for (int iphi=0; iphi<kBarlWedges; iphi++) {
+	int hi = barlIndex(ieta,iphi,sign);
+	goodCell_barl_[hi] = helper.goodCell_barl[ieta][iphi][sign];
+	status_barl_[hi] = std::max<int>(status_barl_[hi],
+					 helper.statusCode_barl[ieta][iphi][sign]);
+      }
+    }
+  }
+
+  // count endcap crystals per ring
+  std::vector<int> ncells(kEndcEtaRings*kSides, 0);
+
+  for (int ix=0; ix<kEndcWedgesX; ix++) {
+    for (int iy=0; iy<kEndcWedgesY; iy++) {
+      for (int sign=0; sign<kSides; sign++) {
+	int hi = endcIndex(ix, iy, sign);
+	if (hi<0) continue;
+
+	int ring = helper.endcapRing_[ix][iy];
+	endcRing_[hi] = ring;
+	goodCell_endc_[hi] = ring!=-1 && helper.goodCell_endc[ix][iy][sign];
+	status_endc_[hi] = std::max<int>(status_endc_[hi],
+					 helper.statusCode_endc[ix][iy][sign]);
+	if (ring!=-1) ncells[ring+sign*kEndcEtaRings]++;
+      }
+    }
+  }
+
+  buildRings(ncells);
+}
+
+
+void EcalPhiSymAccumulator::setup(const std::vector<short>& ring_endc,
+				  const std::vector<unsigned char>& status_barl,
+				  const std::vector<unsigned char>& status_endc,
+				  int statusThreshold){
+
+  for (unsigned int hi=0; hi<status_barl_.size() && hi<status_barl.size(); hi++)
+    status_barl_[hi] = std::max(status_barl_[hi], status_barl[hi]);
+
+  std::vector<int> ncells(kEndcEtaRings*kSides, 0);
+
+  for (int ix=0; ix<kEndcWedgesX; ix++) {
+    for (int iy=0; iy<kEndcWedgesY; iy++) {
+      for (int sign=0; sign<kSides; sign++) {
+	int hi = endcIndex(ix, iy, sign);
+	if (hi<0 || hi>=int(ring_endc.size())) continue;
+
+	int ring = ring_endc[hi];
+	endcRing_[hi] = ring;
+	if (hi<int(status_endc.size()))
+	  status_endc_[hi] = std::max(status_endc_[hi], status_endc[hi]);
+	if (ring!=-1) ncells[ring+sign*kEndcEtaRings]++;
+      }
+    }
+  }
+
+  buildRings(ncells);
+  applyStatusThreshold(statusThreshold);
+}
+
+
+void EcalPhiSymAccumulator::buildRings(const std::vector<int>& ncells){
+
+  endcRingOffsets_[0] = 0;
+  for (unsigned int i=0; i<ncells.size(); i++)
+    endcRingOffsets_[i+1] = endcRingOffsets_[i] + ncells[i];
+
+  endcRingCells_.assign(endcRingOffsets_.back(), -1);
+  std::vector<int> next(endcRingOffsets_.begin(), endcRingOffsets_.end()-1);
+
+  for (int ix=0; ix<kEndcWedgesX; ix++) {
+    for (int iy=0; iy<kEndcWedgesY; iy++) {
+      for (int sign=0; sign<kSides; sign++) {
+	int hi = endcIndex(ix, iy, sign);
+	if (hi<0 || endcRing_[hi]==-1) continue;
+	endcRingCells_[next[endcRing_[hi]+sign*kEndcEtaRings]++] = hi;
+      }
+    }
+  }
+
+}
+
+
+void EcalPhiSymAccumulator::fill(EcalPhiSymLumiSums& lumiSums) const {
+
+  lumiSums.etsum_barl_.resize(etsum_barl_.size());
+  for (unsigned int i=0; i<etsum_barl_.size(); i++)
+    lumiSums.etsum_barl_[i] = fixedPoint_ ? etsumKeV_barl_[i]*1e-6 : etsum_barl_[i];
+  lumiSums.nhits_barl_  = nhits_barl_;
+  lumiSums.status_barl_ = status_barl_;
+  lumiSums.et2sum_barl_.resize(et2sum_barl_.size());
+  for (unsigned int i=0; i<et2sum_barl_.size(); i++)
+    lumiSums.et2sum_barl_[i] = fixedPoint_ ? et2sumKeV_barl_[i]*1e-6 : et2sum_barl_[i];
+
+  lumiSums.etsum_endc_.resize(etsum_endc_.size());
+  for (unsigned int i=0; i<etsum_endc_.size(); i++)
+    lumiSums.etsum_endc_[i] = fixedPoint_ ? etsumKeV_endc_[i]*1e-6 : etsum_endc_[i];
+  lumiSums.nhits_endc_  = nhits_endc_;
+  lumiSums.status_endc_ = status_endc_;
+  lumiSums.et2sum_endc_.resize(et2sum_endc_.size());
+  for (unsigned int i=0; i<et2sum_endc_.size(); i++)
+    lumiSums.et2sum_endc_[i] = fixedPoint_ ? et2sumKeV_endc_[i]*1e-6 : et2sum_endc_[i];
+}
+
+
+void EcalPhiSymAccumulator::add(const EcalPhiSymLumiSums& lumiSums){
+
+  if (lumiSums.etsum_barl_.size()!=etsum_barl_.size() ||
+      lumiSums.etsum_endc_.size()!=etsum_endc_.size()) {
+    edm::LogError("PhiSym") << "Lumi section sums of the wrong size, not added" << std::endl;
+    return;
+  }
+
+  for (unsigned int i=0; i<etsum_barl_.size(); i++) {
+    if (fixedPoint_) {
+      if (!addKeV(etsumKeV_barl_[i], toKeV(lumiSums.etsum_barl_[i]))) overflows_++;
+    } else {
+      etsum_barl_[i] += lumiSums.etsum_barl_[i];
+    }
+    nhits_barl_[i] += lumiSums.nhits_barl_[i];
+    status_barl_[i] = std::max(status_barl_[i], lumiSums.status_barl_[i]);
+  }
+  for (unsigned int i=0; i<etsum_endc_.size(); i++) {
+    if (fixedPoint_) {
+      if (!addKeV(etsumKeV_endc_[i], toKeV(lumiSums.etsum_endc_[i]))) overflows_++;
+    } else {
+      etsum_endc_[i] += lumiSums.etsum_endc_[i];
+    }
+    nhits_endc_[i] += lumiSums.nhits_endc_[i];
+    status_endc_[i] = std::max(status_endc_[i], lumiSums.status_endc_[i]);
+  }
+
+  for (unsigned int i=0; i<et2sum_barl_.size(); i++) {
+    if (fixedPoint_) {
+      if (!addKeV(et2sumKeV_barl_[i], toKeV(lumiSums.et2sum_barl_[i]))) overflows_++;
+    } else {
+      et2sum_barl_[i] += lumiSums.et2sum_barl_[i];
+    }
+  }
+  for (unsigned int i=0; i<et2sum_endc_.size(); i++) {
+    if (fixedPoint_) {
+      if (!addKeV(et2sumKeV_endc_[i], toKeV(lumiSums.et2sum_endc_[i]))) overflows_++;
+    } else {
+      et2sum_endc_[i] += lumiSums.et2sum_endc_[i];
+    }
+  }
+  if (fixedPoint_) updateEtSums();
+}
+
+
+void EcalPhiSymAccumulator::writeState(std::ostream& out) const {
+
+  phisym::writeVector(out, etsum_barl_);
+  phisym::writeVector(out, etsumKeV_barl_);
+  phisym::writeVector(out, nhits_barl_);
+  phisym::writeVector(out, status_barl_);
+  phisym::writeVector(out, esum_barl_);
+  phisym::writeVector(out, et2sum_barl_);
+  phisym::writeVector(out, e2sum_barl_);
+  phisym::writeVector(out, esumKeV_barl_);
+  phisym::writeVector(out, et2sumKeV_barl_);
+  phisym::writeVector(out, e2sumKeV_barl_);
+
+  phisym::writeVector(out, etsum_endc_);
+  phisym::writeVector(out, etsumKeV_endc_);
+  phisym::writeVector(out, nhits_endc_);
+  phisym::writeVector(out, status_endc_);
+  phisym::writeVector(out, esum_endc_);
+  phisym::writeVector(out, et2sum_endc_);
+  phisym::writeVector(out, e2sum_endc_);
+  phisym::writeVector(out, esumKeV_endc_);
+  phisym::writeVector(out, et2sumKeV_endc_);
+  phisym::writeVector(out, e2sumKeV_endc_);
+
+  phisym::writePod(out, overflows_);
+}
+
+
+bool EcalPhiSymAccumulator::readState(std::istream& in){
+
+  return
+    phisym::readVector(in, etsum_barl_) &&
+    phisym::readVector(in, etsumKeV_barl_) &&
+    phisym::readVector(in, nhits_barl_) &&
+    phisym::readVector(in, status_barl_) &&
+    phisym::readVector(in, esum_barl_) &&
+    phisym::readVector(in, et2sum_barl_) &&
+    phisym::readVector(in, e2sum_barl_) &&
+    phisym::readVector(in, esumKeV_barl_) &&
+    phisym::readVector(in, et2sumKeV_barl_) &&
+    phisym::readVector(in, e2sumKeV_barl_) &&
+    phisym::readVector(in, etsum_endc_) &&
+    phisym::readVector(in, etsumKeV_endc_) &&
+    phisym::readVector(in, nhits_endc_) &&
+    phisym::readVector(in, status_endc_) &&
+    phisym::readVector(in, esum_endc_) &&
+    phisym::readVector(in, et2sum_endc_) &&
+    phisym::readVector(in, e2sum_endc_) &&
+    phisym::readVector(in, esumKeV_endc_) &&
+    phisym::readVector(in, et2sumKeV_endc_) &&
+    phisym::readVector(in, e2sumKeV_endc_) &&
+    phisym::readPod(in, overflows_);
+}
+
+
+namespace {
+
+  template <class T>
+  size_t bytes(const std::vector<T>& v) { return v.capacity()*sizeof(T); }
+
+  size_t bytes(const std::vector<bool>& v) { return v.capacity()/8; }
+
+}
+
+
+size_t EcalPhiSymAccumulator::memory() const {
+
+  return sizeof(*this) +
+    bytes(etsum_barl_) + bytes(etsumKeV_barl_) + bytes(nhits_barl_) + bytes(goodCell_barl_) +
+    bytes(status_barl_) + bytes(esum_barl_) + bytes(et2sum_barl_) + bytes(e2sum_barl_) +
+    bytes(esumKeV_barl_) + bytes(et2sumKeV_barl_) + bytes(e2sumKeV_barl_) +
+    bytes(etsum_endc_) + bytes(etsumKeV_endc_) + bytes(nhits_endc_) + bytes(goodCell_endc_) +
+    bytes(status_endc_) + bytes(esum_endc_) + bytes(et2sum_endc_) + bytes(e2sum_endc_) +
+    bytes(esumKeV_endc_) + bytes(et2sumKeV_endc_) + bytes(e2sumKeV_endc_) +
+    bytes(endcIndex_) + bytes(endcRing_) + bytes(endcRingOffsets_) + bytes(endcRingCells_);
+}
+
+
+void EcalPhiSymAccumulator::setFixedPoint(bool fixedPoint){
+
+  fixedPoint_ = fixedPoint;
+  unsigned int nbarl = fixedPoint ? etsum_barl_.size() : 0;
+  unsigned int nendc = fixedPoint ? etsum_endc_.size() : 0;
+  etsumKeV_barl_ .assign(nbarl, 0);
+  esumKeV_barl_  .assign(nbarl, 0);
+  et2sumKeV_barl_.assign(nbarl, 0);
+  e2sumKeV_barl_ .assign(nbarl, 0);
+  etsumKeV_endc_ .assign(nendc, 0);
+  esumKeV_endc_  .assign(nendc, 0);
+  et2sumKeV_endc_.assign(nendc, 0);
+  e2sumKeV_endc_ .assign(nendc, 0);
+}
+
+
+void EcalPhiSymAccumulator::applyStatusThreshold(int statusThreshold){
+
+  for (unsigned int hi=0; hi<goodCell_barl_.size(); hi++)
+    goodCell_barl_[hi] = status_barl_[hi] <= statusThreshold;
+  for (unsigned int hi=0; hi<goodCell_endc_.size(); hi++)
+    goodCell_endc_[hi] = endcRing_[hi]!=-1 && status_endc_[hi] <= statusThreshold;
+}
+
+
+void EcalPhiSymAccumulator::reset(){
+
+  std::fill(etsum_barl_.begin(), etsum_barl_.end(), 0.);
+  std::fill(nhits_barl_.begin(), nhits_barl_.end(), 0);
+  std::fill(etsum_endc_.begin(), etsum_endc_.end(), 0.);
+  std::fill(nhits_endc_.begin(), nhits_endc_.end(), 0);
+  std::fill(etsumKeV_barl_.begin(), etsumKeV_barl_.end(), 0);
+  std::fill(etsumKeV_endc_.begin(), etsumKeV_endc_.end(), 0);
+  std::fill(esumKeV_barl_.begin(),   esumKeV_barl_.end(),   0);
+  std::fill(et2sumKeV_barl_.begin(), et2sumKeV_barl_.end(), 0);
+  std::fill(e2sumKeV_barl_.begin(),  e2sumKeV_barl_.end(),  0);
+  std::fill(esumKeV_endc_.begin(),   esumKeV_endc_.end(),   0);
+  std::fill(et2sumKeV_endc_.begin(), et2sumKeV_endc_.end(), 0);
+  std::fill(e2sumKeV_endc_.begin(),  e2sumKeV_endc_.end(),  0);
+  std::fill(esum_barl_.begin(),   esum_barl_.end(),   0.);
+  std::fill(et2sum_barl_.begin(), et2sum_barl_.end(), 0.);
+  std::fill(e2sum_barl_.begin(),  e2sum_barl_.end(),  0.);
+  std::fill(esum_endc_.begin(),   esum_endc_.end(),   0.);
+  std::fill(et2sum_endc_.begin(), et2sum_endc_.end(), 0.);
+  std::fill(e2sum_endc_.begin(),  e2sum_endc_.end(),  0.);
+  overflows_=0;
+}
+
+
+void EcalPhiSymAccumulator::updateEtSums(){
+
+  for (unsigned int i=0; i<etsumKeV_barl_.size(); i++) {
+    etsum_barl_[i]  = etsumKeV_barl_[i]*1e-6;
+    esum_barl_[i]   = esumKeV_barl_[i]*1e-6;
+    et2sum_barl_[i] = et2sumKeV_barl_[i]*1e-6;
+    e2sum_barl_[i]  = e2sumKeV_barl_[i]*1e-6;
+  }
+  for (unsigned int i=0; i<etsumKeV_endc_.size(); i++) {
+    etsum_endc_[i]  = etsumKeV_endc_[i]*1e-6;
+    esum_endc_[i]   = esumKeV_endc_[i]*1e-6;
+    et2sum_endc_[i] = et2sumKeV_endc_[i]*1e-6;
+    e2sum_endc_[i]  = e2sumKeV_endc_[i]*1e-6;
+  }
+}
+
+
+void EcalPhiSymAccumulator::add(const EcalPhiSymAccumulator& other){
+
+  for (unsigned int i=0; i<etsum_barl_.size(); i++) {
+    etsum_barl_[i] += other.etsum_barl_[i];
+    nhits_barl_[i] += other.nhits_barl_[i];
+    status_barl_[i] = std::max(status_barl_[i], other.status_barl_[i]);
+    esum_barl_[i]   += other.esum_barl_[i];
+    et2sum_barl_[i] += other.et2sum_barl_[i];
+    e2sum_barl_[i]  += other.e2sum_barl_[i];
+  }
+  for (unsigned int i=0; i<etsum_endc_.size(); i++) {
+    etsum_endc_[i] += other.etsum_endc_[i];
+    nhits_endc_[i] += other.nhits_endc_[i];
+    status_endc_[i] = std::max(status_endc_[i], other.status_endc_[i]);
+    esum_endc_[i]   += other.esum_endc_[i];
+    et2sum_endc_[i] += other.et2sum_endc_[i];
+    e2sum_endc_[i]  += other.e2sum_endc_[i];
+  }
+
+  if (fixedPoint_ && other.fixedPoint_) {
+    for (unsigned int i=0; i<etsumKeV_barl_.size(); i++) {
+      if (!addKeV(etsumKeV_barl_[i],  other.etsumKeV_barl_[i]))  overflows_++;
+      if (!addKeV(esumKeV_barl_[i],   other.esumKeV_barl_[i]))   overflows_++;
+      if (!addKeV(et2sumKeV_barl_[i], other.et2sumKeV_barl_[i])) overflows_++;
+      if (!addKeV(e2sumKeV_barl_[i],  other.e2sumKeV_barl_[i]))  overflows_++;
+    }
+    for (unsigned int i=0; i<etsumKeV_endc_.size(); i++) {
+      if (!addKeV(etsumKeV_endc_[i],  other.etsumKeV_endc_[i]))  overflows_++;
+      if (!addKeV(esumKeV_endc_[i],   other.esumKeV_endc_[i]))   overflows_++;
+      if (!addKeV(et2sumKeV_endc_[i], other.et2sumKeV_endc_[i])) overflows_++;
+      if (!addKeV(e2sumKeV_endc_[i],  other.e2sumKeV_endc_[i]))  overflows_++;
+    }
+  }
+  overflows_ += other.overflows_;
+}
+
+
+void EcalPhiSymAccumulator::write(const std::string& barlFile,
+				  const std::string& endcFile,
+				  int eventSet) const {
+
+  if (overflows_)
+    edm::LogError("PhiSym") << "Fixed-point sum overflow: " << overflows_ 
+			    << " additions dropped" << std::endl;
+
+  std::ofstream etsum_barl_out(barlFile.c_str(),std::ios::out);
+
+  for (int ieta=0; ieta<kBarlRings; ieta++) {
+    for (int iphi=0; iphi<kBarlWedges; iphi++) {
+      for (int sign=0; sign<kSides; sign++) {
+	int hi = barlIndex(ieta, iphi, sign);
+	etsum_barl_out << eventSet << " " << ieta << " " << iphi << " " << sign
+		       << " ";
+	if (fixedPoint_) etsum_barl_out << keVToString(etsumKeV_barl_[hi]);
+	else             etsum_barl_out << etsum_barl_[hi];
+	etsum_barl_out << " " << nhits_barl_[hi] << " "
+		       << int(status_barl_[hi]) << " ";
+	if (fixedPoint_)
+	  etsum_barl_out << keVToString(esumKeV_barl_[hi]) << " "
+			 << keVToString(et2sumKeV_barl_[hi]) << " "
+			 << keVToString(e2sumKeV_barl_[hi]) << std::endl;
+	else
+	  etsum_barl_out << esum_barl_[hi] << " "
+			 << et2sum_barl_[hi] << " " << e2sum_barl_[hi] << std::endl;
+      }
+    }
+  }
+  etsum_barl_out.close();
+
+  std::ofstream etsum_endc_out(endcFile.c_str(),std::ios::out);
+  for (int ix=0; ix<kEndcWedgesX; ix++) {
+    for (int iy=0; iy<kEndcWedgesY; iy++) {
+      for (int sign=0; sign<kSides; sign++) {
+	int hi = endcIndex(ix, iy, sign);
+	if (hi<0 || endcRing_[hi]==-1) continue;
+	etsum_endc_out << eventSet << " " << ix << " " << iy << " " << sign
+		       << " ";
+	if (fixedPoint_) etsum_endc_out << keVToString(etsumKeV_endc_[hi]);
+	else             etsum_endc_out << etsum_endc_[hi];
+	etsum_endc_out << " " << nhits_endc_[hi] << " "
+		       << endcRing_[hi] << " " << int(status_endc_[hi]) << " ";
+	if (fixedPoint_)
+	  etsum_endc_out << keVToString(esumKeV_endc_[hi]) << " "
+			 << keVToString(et2sumKeV_endc_[hi]) << " "
+			 << keVToString(e2sumKeV_endc_[hi]) << std::endl;
+	else
+	  etsum_endc_out << esum_endc_[hi] << " " << et2sum_endc_[hi] << " "
+			 << e2sum_endc_[hi] << std::endl;
+      }
+    }
+  }
+  etsum_endc_out.close();
+}
+
+
+bool EcalPhiSymAccumulator::read(const std::string& barlFile,
+				 const std::string& endcFile){
+
+  int ieta,iphi,sign,ix,iy,dummy,status;
+  double etsum,esum,et2sum,e2sum;
+  unsigned int nhits;
+  std::string line;
+  bool moments=true;
+
+  // files written before the status column was added have none
+  std::ifstream etsum_barl_in(barlFile.c_str(), std::ios::in);
+  while ( std::getline(etsum_barl_in, line) ) {
+    std::istringstream fields(line);
+    if (!(fields >> dummy >> ieta >> iphi >> sign >> etsum >> nhits)) continue;
+    int hi = barlIndex(ieta, iphi, sign);
+    if (fields >> status) status_barl_[hi] = std::max<int>(status_barl_[hi], status);
+    if (fields >> esum >> et2sum >> e2sum) {
+      esum_barl_[hi]   += esum;
+      et2sum_barl_[hi] += et2sum;
+      e2sum_barl_[hi]  += e2sum;
+      if (fixedPoint_ && !(addKeV(esumKeV_barl_[hi],   toKeV(esum)) &&
+			   addKeV(et2sumKeV_barl_[hi], toKeV(et2sum)) &&
+			   addKeV(e2sumKeV_barl_[hi],  toKeV(e2sum)))) overflows_++;
+    } else
+      moments=false;
+    if (fixedPoint_ && !addKeV(etsumKeV_barl_[hi], toKeV(etsum))) overflows_++;
+    etsum_barl_[hi]+=etsum;
+    nhits_barl_[hi]+=nhits;
+  }
+
+  std::ifstream etsum_endc_in(endcFile.c_str(), std::ios::in);
+  while ( std::getline(etsum_endc_in, line) ) {
+    std::istringstream fields(line);
+    if (!(fields >> dummy >> ix >> iy >> sign >> etsum >> nhits >> dummy)) continue;
+    int hi = endcIndex(ix, iy, sign);
+    if (hi<0) continue;
+    if (fields >> status) status_endc_[hi] = std::max<int>(status_endc_[hi], status);
+    if (fields >> esum >> et2sum >> e2sum) {
+      esum_endc_[hi]   += esum;
+      et2sum_endc_[hi] += et2sum;
+      e2sum_endc_[hi]  += e2sum;
+      if (fixedPoint_ && !(addKeV(esumKeV_endc_[hi],   toKeV(esum)) &&
+			   addKeV(et2sumKeV_endc_[hi], toKeV(et2sum)) &&
+			   addKeV(e2sumKeV_endc_[hi],  toKeV(e2sum)))) overflows_++;
+    } else
+      moments=false;
+    if (fixedPoint_ && !addKeV(etsumKeV_endc_[hi], toKeV(etsum))) overflows_++;
+    etsum_endc_[hi]+=etsum;
+    nhits_endc_[hi]+=nhits;
+  }
+
+  if (fixedPoint_) updateEtSums();
+
+  if (overflows_)
+    edm::LogError("PhiSym") << "Fixed-point sum overflow reading " << barlFile << ", "
+			    << endcFile << ": " << overflows_ 
+			    << " additions dropped" << std::endl;
+
+  return moments;
+}
@@ -0,0 +1,131 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCheckpoint.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Sums.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace {
+
+  const char kMagic[4]    = {'P','S','C','K'};
+  const char kEndMagic[4] = {'K','C','S','P'};
+
+}
+
+
+const uint32_t EcalPhiSymCheckpoint::kVersion;
+
+
+//_____________________________________________________________________________
+
+EcalPhiSymCheckpoint::EcalPhiSymCheckpoint() :
+  everyLumis_(0), everySeconds_(0.), last_(0),
+  lumisSinceWrite_(0), lastWrite_(time(0)) {}
+
+
+void EcalPhiSymCheckpoint::configure(const std::string& fileName, unsigned int everyLumis,
+				     double everySeconds){
+
+  fileName_     = fileName;
+  everyLumis_   = everyLumis;
+  everySeconds_ = everySeconds;
+  lastWrite_    = time(0);
+}
+
+
+bool EcalPhiSymCheckpoint::resume(EcalPhiSymStep1Sums& sums){
+
+  std::ifstream in(fileName_.c_str(), std::ios::in | std::ios::binary);
+  if (!in) return false;
+
+  char magic[4];
+  uint32_t version, run, lumi;
+  uint64_t nlumis;
+  if (!in.read(magic, 4) || memcmp(magic, kMagic, 4)!=0 ||
+      !phisym::readPod(in, version) || version!=kVersion ||
+      !phisym::readPod(in, run) || !phisym::readPod(in, lumi) ||
+      !phisym::readPod(in, nlumis)) {
+    edm::LogError("PhiSym") << fileName_ << " is not a checkpoint of version "
+			    << kVersion << ", not resumed" << std::endl;
+    return false;
+  }
+
+  std::vector<uint64_t> lumis(nlumis);
+  if (nlumis) in.read(reinterpret_cast<char*>(&lumis[0]), nlumis*sizeof(uint64_t));
+
+  // read into a copy, so that a checkpoint of another configuration
+  // leaves sums untouched
+  EcalPhiSymStep1Sums state(sums);
+  state.reset();
+  if (!in || !state.readState(in) ||
+      !in.read(magic, 4) || memcmp(magic, kEndMagic, 4)!=0) {
+    edm::LogError("PhiSym") << fileName_ << " is truncated or was written with another "
+			    << "configuration, not resumed" << std::endl;
+    return false;
+  }
+
+  sums.add(state);
+  resumed_.insert(lumis.begin(), lumis.end());
+  completed_ = lumis;
+  last_ = key(run, lumi);
+
+  edm::LogInfo("PhiSym") << "Resumed from " << fileName_ << ": " << nlumis
+			 << " lumi sections, last run " << run << " lumi section " << lumi;
+  return true;
+}
+
+
+void EcalPhiSymCheckpoint::complete(uint32_t run, uint32_t lumi){
+
+  if (resumed(run, lumi)) return;
+  completed_.push_back(key(run, lumi));
+  last_ = key(run, lumi);
+  lumisSinceWrite_++;
+}
+
+
+bool EcalPhiSymCheckpoint::due(unsigned int pending) const {
+
+  if (!active()) return false;
+  if (everyLumis_ && lumisSinceWrite_+pending >= everyLumis_) return true;
+  return everySeconds_>0. && difftime(time(0), lastWrite_) >= everySeconds_;
+}
+
+
+bool EcalPhiSymCheckpoint::write(const EcalPhiSymStep1Sums& sums){
+
+  std::string tmpName = fileName_+".tmp";
+  std::ofstream out(tmpName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+  out.write(kMagic, 4);
+  phisym::writePod(out, kVersion);
+  phisym::writePod(out, uint32_t(last_ >> 32));
+  phisym::writePod(out, uint32_t(last_ & 0xffffffff));
+  phisym::writePod(out, uint64_t(completed_.size()));
+  if (!completed_.empty())
+    out.write(reinterpret_cast<const char*>(&completed_[0]), completed_.size()*sizeof(uint64_t));
+  sums.writeState(out);
+  out.write(kEndMagic, 4);
+  out.close();
+
+  // on disk before it replaces the previous checkpoint
+  int fd = ::open(tmpName.c_str(), O_RDONLY);
+  bool synced = fd>=0 && fsync(fd)==0;
+  if (fd>=0) ::close(fd);
+
+  if (out.fail() || !synced || rename(tmpName.c_str(), fileName_.c_str())!=0) {
+    edm::LogError("PhiSym") << "Can't write checkpoint " << fileName_ << std::endl;
+    remove(tmpName.c_str());
+    return false;
+  }
+
+  lumisSinceWrite_ = 0;
+  lastWrite_ = time(0);
+  return true;
+}
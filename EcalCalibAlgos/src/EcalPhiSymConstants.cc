@@ -0,0 +1,43 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConstants.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+
+#include <algorithm>
+
+
+EcalPhiSymConstants::EcalPhiSymConstants(float value) :
+  barl_(EBDetId::kSizeForDenseIndexing, value),
+  endc_(EEDetId::kSizeForDenseIndexing, value)
+{
+}
+
+
+void EcalPhiSymConstants::fill(float value){
+
+  std::fill(barl_.begin(), barl_.end(), value);
+  std::fill(endc_.begin(), endc_.end(), value);
+}
+
+
+void EcalPhiSymConstants::load(const EcalIntercalibConstants& constants){
+
+  // the container items are stored by hashed index
+  const std::vector<EcalIntercalibConstant>& barl = constants.barrelItems();
+  const std::vector<EcalIntercalibConstant>& endc = constants.endcapItems();
+
+  std::copy(barl.begin(), barl.begin()+std::min(barl.size(), barl_.size()),
+	    barl_.begin());
+  std::copy(endc.begin(), endc.begin()+std::min(endc.size(), endc_.size()),
+	    endc_.begin());
+}
+
+
+void EcalPhiSymConstants::store(EcalIntercalibConstants& constants) const {
+
+  for (unsigned int hi=0; hi<barl_.size(); hi++)
+    constants.setValue(EBDetId::unhashIndex(hi).rawId(), barl_[hi]);
+
+  for (unsigned int hi=0; hi<endc_.size(); hi++)
+    constants.setValue(EEDetId::unhashIndex(hi).rawId(), endc_[hi]);
+}
@@ -0,0 +1,141 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConvergence.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+  // per-ring sums of the crystal ET sums, their squares and their
+  // squared relative precisions
+  struct RingSums {
+    int    ngood;
+    bool   empty;
+    double etsum;
+    double etsum2;
+    double rel2;
+  };
+
+  void addCrystal(RingSums& ring, double etsum, double et2sum, unsigned int nhits){
+    ring.ngood++;
+    ring.etsum  += etsum;
+    ring.etsum2 += etsum*etsum;
+    if (nhits==0 || etsum<=0.) ring.empty=true;
+    else ring.rel2 += et2sum/(etsum*etsum);
+  }
+
+  void finish(const RingSums& ring, int& ngood, double& mean,
+	      double& spread, double& precision){
+    ngood = ring.ngood;
+    mean = spread = 0.;
+    precision = 1.;
+    if (!ring.ngood) return;
+
+    mean = ring.etsum/ring.ngood;
+    double var = ring.etsum2/ring.ngood - mean*mean;
+    spread = mean>0. ? sqrt(std::max(var, 0.))/mean : 0.;
+    if (!ring.empty) precision = sqrt(ring.rel2/ring.ngood);
+  }
+
+}
+
+
+void EcalPhiSymConvergence::compute(const EcalPhiSymAccumulator& sums,
+				    const EcalPhiSymCrystalTable& crystals){
+
+  RingSums zero = {0, false, 0., 0., 0.};
+
+  RingSums barl[kBarlRings][kSides];
+  for (int ieta=0; ieta<kBarlRings; ieta++)
+    for (int sign=0; sign<kSides; sign++) barl[ieta][sign] = zero;
+
+  for (unsigned int hi=0; hi<crystals.good_barl_.size(); hi++) {
+    if (!crystals.good_barl_[hi]) continue;
+    double etsum  = sums.fixedPoint() ? sums.etsumKeV_barl_[hi]*1e-6  : sums.etsum_barl_[hi];
+    double et2sum = sums.fixedPoint() ? sums.et2sumKeV_barl_[hi]*1e-6 : sums.et2sum_barl_[hi];
+    addCrystal(barl[crystals.ring_barl_[hi]][int(crystals.sign_barl_[hi])],
+	       etsum, et2sum, sums.nhits_barl_[hi]);
+  }
+
+  for (int ieta=0; ieta<kBarlRings; ieta++)
+    for (int sign=0; sign<kSides; sign++)
+      finish(barl[ieta][sign], ngood_barl_[ieta][sign], mean_barl_[ieta][sign],
+	     spread_barl_[ieta][sign], precision_barl_[ieta][sign]);
+
+
+  RingSums endc[kEndcEtaRings][kSides];
+  for (int ring=0; ring<kEndcEtaRings; ring++)
+    for (int sign=0; sign<kSides; sign++) endc[ring][sign] = zero;
+
+  for (unsigned int hi=0; hi<crystals.good_endc_.size(); hi++) {
+    if (!crystals.good_endc_[hi] || crystals.ring_endc_[hi]==-1) continue;
+    double etsum  = sums.fixedPoint() ? sums.etsumKeV_endc_[hi]*1e-6  : sums.etsum_endc_[hi];
+    double et2sum = sums.fixedPoint() ? sums.et2sumKeV_endc_[hi]*1e-6 : sums.et2sum_endc_[hi];
+    addCrystal(endc[crystals.ring_endc_[hi]][int(crystals.sign_endc_[hi])],
+	       etsum, et2sum, sums.nhits_endc_[hi]);
+  }
+
+  for (int ring=0; ring<kEndcEtaRings; ring++)
+    for (int sign=0; sign<kSides; sign++)
+      finish(endc[ring][sign], ngood_endc_[ring][sign], mean_endc_[ring][sign],
+	     spread_endc_[ring][sign], precision_endc_[ring][sign]);
+}
+
+
+bool EcalPhiSymConvergence::converged(double target) const {
+
+  int ring, sign;
+  return worstBarl(ring, sign) <= target && worstEndc(ring, sign) <= target;
+}
+
+
+double EcalPhiSymConvergence::worstBarl(int& ring, int& sign) const {
+
+  double worst=0.;
+  ring = sign = -1;
+  for (int ieta=0; ieta<kBarlRings; ieta++)
+    for (int s=0; s<kSides; s++)
+      if (ngood_barl_[ieta][s] && precision_barl_[ieta][s] > worst) {
+	worst = precision_barl_[ieta][s];
+	ring = ieta;
+	sign = s;
+      }
+  return worst;
+}
+
+
+double EcalPhiSymConvergence::worstEndc(int& ring, int& sign) const {
+
+  double worst=0.;
+  ring = sign = -1;
+  for (int r=0; r<kEndcEtaRings; r++)
+    for (int s=0; s<kSides; s++)
+      if (ngood_endc_[r][s] && precision_endc_[r][s] > worst) {
+	worst = precision_endc_[r][s];
+	ring = r;
+	sign = s;
+      }
+  return worst;
+}
+
+
+double EcalPhiSymConvergence::maxSpreadBarl() const {
+
+  double spread=0.;
+  for (int ieta=0; ieta<kBarlRings; ieta++)
+    for (int sign=0; sign<kSides; sign++)
+      spread = std::max(spread, spread_barl_[ieta][sign]);
+  return spread;
+}
+
+
+double EcalPhiSymConvergence::maxSpreadEndc() const {
+
+  double spread=0.;
+  for (int ring=0; ring<kEndcEtaRings; ring++)
+    for (int sign=0; sign<kSides; sign++)
+      spread = std::max(spread, spread_endc_[ring][sign]);
+  return spread;
+}
@@ -0,0 +1,119 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+
+// Geometry
+#include "Geometry/CaloGeometry/interface/CaloSubdetectorGeometry.h"
+#include "Geometry/CaloGeometry/interface/CaloCellGeometry.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+
+#include <cmath>
+
+namespace {
+
+  // largest float not above cut, so that for a float energy
+  // (e > cut) gives the same answer in single and double precision
+  float floatCut(double cut){
+    float fcut = cut;
+    if (fcut > cut) fcut = nextafterf(fcut, -HUGE_VALF);
+    return fcut;
+  }
+
+}
+
+void EcalPhiSymCrystalTable::setup(const CaloGeometry* geometry,
+				   const EcalGeomPhiSymHelper& helper,
+				   double eCut_barl, double ap, double b,
+				   bool allChannels){
+
+  const int nBarl = EBDetId::kSizeForDenseIndexing;
+  eta_barl_    .assign(nBarl, 0.);
+  invCosh_barl_.assign(nBarl, 0.);
+  eCut_barl_   .assign(nBarl, 0.);
+  etThr_barl_  .assign(nBarl, 0.);
+  ring_barl_   .assign(nBarl, -1);
+  sign_barl_   .assign(nBarl, 0);
+  good_barl_   .assign(nBarl, 0);
+  sel_barl_    .assign(nBarl, 0);
+
+  const CaloSubdetectorGeometry *barrelGeometry =
+    geometry->getSubdetectorGeometry(DetId::Ecal, EcalBarrel);
+
+  const std::vector<DetId>& barrelCells = geometry->getValidDetIds(DetId::Ecal, EcalBarrel);
+  std::vector<DetId>::const_iterator barrelIt;
+  for (barrelIt=barrelCells.begin(); barrelIt!=barrelCells.end(); barrelIt++) {
+    EBDetId eb(*barrelIt);
+    int hi   = eb.hashedIndex();
+    int sign = eb.zside()>0 ? 1 : 0;
+    int ieta = abs(eb.ieta())-1;
+
+    float eta = barrelGeometry->getGeometry(eb)->getPosition().eta();
+
+    eta_barl_[hi]     = eta;
+    invCosh_barl_[hi] = 1./cosh(eta);
+    ring_barl_[hi]    = ieta;
+    sign_barl_[hi]    = sign;
+    good_barl_[hi]    = helper.goodCell_barl[ieta][eb.iphi()-1][sign];
+    sel_barl_[hi]     = allChannels || good_barl_[hi];
+  }
+
+
+  const int nEndc = EEDetId::kSizeForDenseIndexing;
+  eta_endc_    .assign(nEndc, 0.);
+  invCosh_endc_.assign(nEndc, 0.);
+  eCut_endc_   .assign(nEndc, 0.);
+  etThr_endc_  .assign(nEndc, 0.);
+  ring_endc_   .assign(nEndc, -1);
+  sign_endc_   .assign(nEndc, 0);
+  good_endc_   .assign(nEndc, 0);
+  sel_endc_    .assign(nEndc, 0);
+
+  etaRing_.assign(kEndcEtaRings, 0.);
+  for (int ring=0; ring<kEndcEtaRings; ring++)
+    etaRing_[ring] = fabs(helper.cellPos_[ring][50].eta());
+
+  const CaloSubdetectorGeometry *endcapGeometry =
+    geometry->getSubdetectorGeometry(DetId::Ecal, EcalEndcap);
+
+  const std::vector<DetId>& endcapCells = geometry->getValidDetIds(DetId::Ecal, EcalEndcap);
+  std::vector<DetId>::const_iterator endcapIt;
+  for (endcapIt=endcapCells.begin(); endcapIt!=endcapCells.end(); endcapIt++) {
+    EEDetId ee(*endcapIt);
+    int hi   = ee.hashedIndex();
+    int sign = ee.zside()>0 ? 1 : 0;
+    int ring = helper.endcapRing_[ee.ix()-1][ee.iy()-1];
+
+    float eta = fabs(endcapGeometry->getGeometry(ee)->getPosition().eta());
+
+    eta_endc_[hi]     = eta;
+    invCosh_endc_[hi] = 1./cosh(eta);
+    ring_endc_[hi]    = ring;
+    sign_endc_[hi]    = sign;
+    good_endc_[hi]    = ring!=-1 && helper.goodCell_endc[ee.ix()-1][ee.iy()-1][sign];
+    sel_endc_[hi]     = ring!=-1 && (allChannels || good_endc_[hi]);
+  }
+
+  setCuts(eCut_barl, ap, b);
+}
+
+
+void EcalPhiSymCrystalTable::setCuts(double eCut_barl, double ap, double b){
+
+  for (unsigned int hi=0; hi<eta_barl_.size(); hi++) {
+    if (invCosh_barl_[hi]==0.) continue;
+    eCut_barl_[hi]  = floatCut(eCut_barl);
+    etThr_barl_[hi] = eCut_barl/cosh(eta_barl_[hi]) + 1.;
+  }
+
+  for (unsigned int hi=0; hi<eta_endc_.size(); hi++) {
+    if (invCosh_endc_[hi]==0.) continue;
+
+    // e_cut = ap + eta_ring*b, no cut for crystals outside the rings
+    int ring = ring_endc_[hi];
+    double eCut_endc = ring!=-1 ? ap + etaRing_[ring]*b : 0.;
+
+    eCut_endc_[hi]  = floatCut(eCut_endc);
+    etThr_endc_[hi] = eCut_endc/cosh(eta_endc_[hi]) + 1.;
+  }
+}
@@ -0,0 +1,131 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymEnergyHistos.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCheckpoint.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+
+EcalPhiSymEnergyHistos::EcalPhiSymEnergyHistos() : nbins_(0) {
+
+  for (int det=0; det<2; det++) low_[det] = high_[det] = width_[det] = 0.;
+}
+
+
+void EcalPhiSymEnergyHistos::book(int nbins, double lowEB, double highEB,
+				  double lowEE, double highEE){
+
+  nbins_   = nbins;
+  low_[0]  = lowEB;
+  high_[0] = highEB;
+  low_[1]  = lowEE;
+  high_[1] = highEE;
+  for (int det=0; det<2; det++) width_[det] = (high_[det]-low_[det])/nbins_;
+
+  counts_barl_.assign(EBDetId::kSizeForDenseIndexing*nbins_, 0);
+  counts_endc_.assign(EEDetId::kSizeForDenseIndexing*nbins_, 0);
+}
+
+
+void EcalPhiSymEnergyHistos::reset(){
+
+  std::fill(counts_barl_.begin(), counts_barl_.end(), 0);
+  std::fill(counts_endc_.begin(), counts_endc_.end(), 0);
+}
+
+
+void EcalPhiSymEnergyHistos::add(const EcalPhiSymEnergyHistos& other){
+
+  for (unsigned int i=0; i<counts_barl_.size(); i++) counts_barl_[i] += other.counts_barl_[i];
+  for (unsigned int i=0; i<counts_endc_.size(); i++) counts_endc_[i] += other.counts_endc_[i];
+}
+
+
+void EcalPhiSymEnergyHistos::writeState(std::ostream& out) const {
+
+  phisym::writePod(out, nbins_);
+  phisym::writeVector(out, counts_barl_);
+  phisym::writeVector(out, counts_endc_);
+}
+
+
+bool EcalPhiSymEnergyHistos::readState(std::istream& in){
+
+  int nbins;
+  return phisym::readPod(in, nbins) && nbins==nbins_ &&
+    phisym::readVector(in, counts_barl_) && phisym::readVector(in, counts_endc_);
+}
+
+
+void EcalPhiSymEnergyHistos::write(const std::string& fileName, int eventSet) const {
+
+  std::ofstream out(fileName.c_str(), std::ios::out);
+
+  out << "# " << nbins_ << " " << low_[0] << " " << high_[0]
+      << " "  << low_[1] << " " << high_[1] << std::endl;
+
+  for (int det=0; det<2; det++) {
+    const std::vector<unsigned int>& counts = det ? counts_endc_ : counts_barl_;
+    int ncells = counts.size()/nbins_;
+    for (int hi=0; hi<ncells; hi++) {
+      const unsigned int* c = &counts[hi*nbins_];
+      if (std::count(c, c+nbins_, 0u)==nbins_) continue;
+      out << eventSet << " " << det << " " << hi;
+      for (int b=0; b<nbins_; b++) out << " " << c[b];
+      out << std::endl;
+    }
+  }
+  out.close();
+}
+
+
+bool EcalPhiSymEnergyHistos::read(const std::string& fileName){
+
+  std::ifstream in(fileName.c_str(), std::ios::in);
+  if (!in) {
+    edm::LogError("PhiSym") << "Can't open " << fileName << std::endl;
+    return false;
+  }
+
+  bool ok=true;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+
+    if (line[0]=='#') {
+      std::string hash;
+      int nbins;
+      double lowEB, highEB, lowEE, highEE;
+      fields >> hash >> nbins >> lowEB >> highEB >> lowEE >> highEE;
+      if (!booked()) {
+	book(nbins, lowEB, highEB, lowEE, highEE);
+      } else if (nbins!=nbins_ ||
+		 fabs(lowEB-low_[0])>1e-6 || fabs(highEB-high_[0])>1e-6 ||
+		 fabs(lowEE-low_[1])>1e-6 || fabs(highEE-high_[1])>1e-6) {
+	edm::LogError("PhiSym") << "Energy histograms with different binning in "
+				<< fileName << std::endl;
+	ok=false;
+	// skip until the next header
+	while (in.peek()!='#' && std::getline(in, line)) {}
+      }
+      continue;
+    }
+
+    if (!booked()) continue;
+
+    int eventSet, det, hi;
+    if (!(fields >> eventSet >> det >> hi)) continue;
+    std::vector<unsigned int>& counts = det ? counts_endc_ : counts_barl_;
+    if (hi<0 || (hi+1)*nbins_>int(counts.size())) continue;
+
+    unsigned int n;
+    for (int b=0; b<nbins_ && fields >> n; b++) counts[hi*nbins_+b] += n;
+  }
+
+  return ok;
+}
@@ -0,0 +1,107 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymEventBins.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/VertexReco/interface/Vertex.h"
+#include "DataFormats/VertexReco/interface/VertexFwd.h"
+#include "DataFormats/L1GlobalTrigger/interface/L1GlobalTriggerReadoutRecord.h"
+
+#include <algorithm>
+#include <sstream>
+
+
+const unsigned int EcalPhiSymEventBins::kMaxL1Bits;
+
+
+EcalPhiSymEventBins::EcalPhiSymEventBins() :
+  useNvtx_(false), useBx_(false), useL1_(false), maxBins_(0) {}
+
+
+EcalPhiSymEventBins::EcalPhiSymEventBins(const edm::ParameterSet& pset) :
+  vertices_(pset.getUntrackedParameter<edm::InputTag>("vertexCollection",edm::InputTag())),
+  nvtxEdges_(pset.getUntrackedParameter<std::vector<int> >("nvtxEdges",std::vector<int>())),
+  bxEdges_(pset.getUntrackedParameter<std::vector<int> >("bxEdges",std::vector<int>())),
+  l1GtRecord_(pset.getUntrackedParameter<edm::InputTag>("l1GtRecord",edm::InputTag("gtDigis"))),
+  l1TechBits_(pset.getUntrackedParameter<std::vector<int> >("l1TechBits",std::vector<int>())),
+  maxBins_(pset.getUntrackedParameter<unsigned int>("maxBins",64))
+{
+
+  std::sort(nvtxEdges_.begin(), nvtxEdges_.end());
+  std::sort(bxEdges_.begin(), bxEdges_.end());
+
+  if (nvtxEdges_.size()>=kMaxNvtxBins) {
+    edm::LogError("PhiSym") << "Too many nvtx bin edges, keeping the first "
+			    << kMaxNvtxBins-1 << std::endl;
+    nvtxEdges_.resize(kMaxNvtxBins-1);
+  }
+  if (bxEdges_.size()>=kMaxBxBins) {
+    edm::LogError("PhiSym") << "Too many bx bin edges, keeping the first "
+			    << kMaxBxBins-1 << std::endl;
+    bxEdges_.resize(kMaxBxBins-1);
+  }
+  if (l1TechBits_.size()>kMaxL1Bits) {
+    edm::LogError("PhiSym") << "Too many L1 technical bits, keeping the first "
+			    << kMaxL1Bits << std::endl;
+    l1TechBits_.resize(kMaxL1Bits);
+  }
+
+  useNvtx_ = !vertices_.label().empty() && !nvtxEdges_.empty();
+  useBx_   = !bxEdges_.empty();
+  useL1_   = !l1TechBits_.empty();
+}
+
+
+unsigned int EcalPhiSymEventBins::findBin(const std::vector<int>& edges, int value){
+
+  return std::upper_bound(edges.begin(), edges.end(), value) - edges.begin();
+}
+
+
+unsigned int EcalPhiSymEventBins::key(const edm::Event& event) const {
+
+  unsigned int key=0;
+
+  if (useNvtx_) {
+    edm::Handle<reco::VertexCollection> vertices;
+    event.getByLabel(vertices_, vertices);
+    int nvtx=0;
+    if (vertices.isValid()) {
+      for (unsigned int i=0; i<vertices->size(); i++)
+	if (!(*vertices)[i].isFake()) nvtx++;
+    } else {
+      edm::LogError("PhiSym") << "Can't get vertices " << vertices_.encode() << std::endl;
+    }
+    key |= findBin(nvtxEdges_, nvtx) << 24;
+  }
+
+  if (useBx_)
+    key |= findBin(bxEdges_, event.bunchCrossing()) << 12;
+
+  if (useL1_) {
+    edm::Handle<L1GlobalTriggerReadoutRecord> gtRecord;
+    event.getByLabel(l1GtRecord_, gtRecord);
+    if (gtRecord.isValid()) {
+      const TechnicalTriggerWord& word = gtRecord->technicalTriggerWord();
+      for (unsigned int i=0; i<l1TechBits_.size(); i++) {
+	unsigned int bit = l1TechBits_[i];
+	if (bit<word.size() && word[bit]) key |= 1u << i;
+      }
+    } else {
+      edm::LogError("PhiSym") << "Can't get L1 record " << l1GtRecord_.encode() << std::endl;
+    }
+  }
+
+  return key;
+}
+
+
+std::string EcalPhiSymEventBins::label(unsigned int key) const {
+
+  std::ostringstream s;
+  if (useNvtx_) s << "nvtx" << (key>>24);
+  if (useBx_)   s << (useNvtx_ ? "_" : "") << "bx" << ((key>>12) & 0xfff);
+  if (useL1_)   s << (useNvtx_ || useBx_ ? "_" : "") << "l1m" << (key & 0xfff);
+  return s.str();
+}
@@ -0,0 +1,8 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHelperRcd.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+
+#include "FWCore/Framework/interface/eventsetuprecord_registration_macro.h"
+#include "FWCore/Utilities/interface/typelookup.h"
+
+EVENTSETUP_RECORD_REG(EcalPhiSymHelperRcd);
+TYPELOOKUP_DATA_REG(EcalGeomPhiSymHelper);
@@ -0,0 +1,42 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHelperSource.h"
+
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+
+
+EcalPhiSymHelperSource::EcalPhiSymHelperSource(const edm::ParameterSet& iConfig) :
+  fromEventSetup_(iConfig.getUntrackedParameter<bool>("esGeomHelper",false)),
+  label_(iConfig.getUntrackedParameter<std::string>("esGeomHelperLabel","")) {}
+
+
+bool EcalPhiSymHelperSource::update(const edm::EventSetup& setup, int statusThreshold,
+				    EcalGeomPhiSymHelper& helper){
+
+  if (fromEventSetup_) {
+    if (!helperWatcher_.check(setup)) return false;
+
+    edm::ESHandle<EcalGeomPhiSymHelper> shared;
+    setup.get<EcalPhiSymHelperRcd>().get(label_, shared);
+    helper = *shared;
+    if (helper.statusThreshold_!=statusThreshold) helper.applyStatusThreshold(statusThreshold);
+    return true;
+  }
+
+  // both watchers updated
+  bool geometryChanged = geometryWatcher_.check(setup);
+  bool statusChanged   = statusWatcher_.check(setup);
+  if (!geometryChanged && !statusChanged) return false;
+
+  edm::ESHandle<EcalChannelStatus> chStatus;
+  setup.get<EcalChannelStatusRcd>().get(chStatus);
+
+  edm::ESHandle<CaloGeometry> geoHandle;
+  setup.get<CaloGeometryRecord>().get(geoHandle);
+
+  helper.setup(&(*geoHandle), &(*chStatus), statusThreshold);
+  return true;
+}
@@ -0,0 +1,190 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitBatch.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+
+// the AVX2 kernels are built as target clones of this file, whatever the
+// flags of the plugin, and chosen at run time by the CPU
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PHISYM_AVX2_CLONES
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+#if defined(PHISYM_AVX2_CLONES)
+
+  bool cpuHasAvx2(){
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  }
+
+  bool useAvx2 = cpuHasAvx2();
+
+  // multiplications are kept separate (no FMA) so that the result is
+  // bit-identical to the scalar loop; returns the first entry not done
+  __attribute__((target("avx2")))
+  int selectAvx2(int n, const int* hi, float* e, float* et, const float* scale, int* pass,
+		 const float* invCosh, const float* eCut, const float* etThr, const int* good){
+
+    int i=0;
+    for (; i+8<=n; i+=8) {
+      __m256i idx = _mm256_loadu_si256((const __m256i*)(hi+i));
+
+      __m256 ve   = _mm256_loadu_ps(e+i);
+      __m256 vs   = _mm256_loadu_ps(scale+i);
+      __m256 vinv = _mm256_i32gather_ps(invCosh, idx, 4);
+      __m256 vcut = _mm256_i32gather_ps(eCut,    idx, 4);
+      __m256 vthr = _mm256_i32gather_ps(etThr,   idx, 4);
+      __m256i vgood = _mm256_i32gather_epi32(good, idx, 4);
+
+      __m256 vet = _mm256_mul_ps(_mm256_mul_ps(ve, vinv), vs);
+      ve = _mm256_mul_ps(ve, vs);
+
+      __m256 m = _mm256_and_ps(_mm256_cmp_ps(ve,  vcut, _CMP_GT_OQ),
+			       _mm256_cmp_ps(vet, vthr, _CMP_LT_OQ));
+      __m256i vpass = _mm256_and_si256(_mm256_castps_si256(m),
+				       _mm256_cmpgt_epi32(vgood, _mm256_setzero_si256()));
+
+      _mm256_storeu_ps(e+i,  ve);
+      _mm256_storeu_ps(et+i, vet);
+      _mm256_storeu_si256((__m256i*)(pass+i), vpass);
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2")))
+  int recutAvx2(int n, const int* hi, const float* e, const float* et, int* pass,
+		const float* eCut, const float* etThr, const int* good){
+
+    int i=0;
+    for (; i+8<=n; i+=8) {
+      __m256i idx = _mm256_loadu_si256((const __m256i*)(hi+i));
+
+      __m256 vcut = _mm256_i32gather_ps(eCut,  idx, 4);
+      __m256 vthr = _mm256_i32gather_ps(etThr, idx, 4);
+      __m256i vgood = _mm256_i32gather_epi32(good, idx, 4);
+
+      __m256 m = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(e+i),  vcut, _CMP_GT_OQ),
+			       _mm256_cmp_ps(_mm256_loadu_ps(et+i), vthr, _CMP_LT_OQ));
+      __m256i vpass = _mm256_and_si256(_mm256_castps_si256(m),
+				       _mm256_cmpgt_epi32(vgood, _mm256_setzero_si256()));
+
+      _mm256_storeu_si256((__m256i*)(pass+i), vpass);
+    }
+    return i;
+  }
+
+#endif
+
+}
+
+
+bool EcalPhiSymHitBatch::avx2(){
+#if defined(PHISYM_AVX2_CLONES)
+  return useAvx2;
+#else
+  return false;
+#endif
+}
+
+
+void EcalPhiSymHitBatch::setAvx2(bool on){
+#if defined(PHISYM_AVX2_CLONES)
+  useAvx2 = on && cpuHasAvx2();
+#endif
+}
+
+
+void EcalPhiSymHitBatch::select(const float* invCosh, const float* eCut,
+				const float* etThr, const int* good){
+
+  int i=0;
+
+#if defined(PHISYM_AVX2_CLONES)
+  if (useAvx2)
+    i = selectAvx2(n, hi, e, et, scale, pass, invCosh, eCut, etThr, good);
+#endif
+
+  for (; i<n; i++) {
+    int h = hi[i];
+    et[i] = e[i]*invCosh[h]*scale[i];
+    e[i]  = e[i]*scale[i];
+    pass[i] = (e[i] > eCut[h] && et[i] < etThr[h] && good[h]) ? -1 : 0;
+  }
+}
+
+
+void EcalPhiSymHitBatch::recut(const float* eCut, const float* etThr,
+			       const int* good){
+
+  int i=0;
+
+#if defined(PHISYM_AVX2_CLONES)
+  if (useAvx2)
+    i = recutAvx2(n, hi, e, et, pass, eCut, etThr, good);
+#endif
+
+  for (; i<n; i++) {
+    int h = hi[i];
+    pass[i] = (e[i] > eCut[h] && et[i] < etThr[h] && good[h]) ? -1 : 0;
+  }
+}
+
+
+int EcalPhiSymHitBatch::accumulate(double* etsum, unsigned int* nhits) const {
+
+  // hashed indices are unique within a collection, no conflicts
+  int nsel=0;
+  for (int i=0; i<n; i++) {
+    if (!pass[i]) continue;
+    etsum[hi[i]] += et[i];
+    nhits[hi[i]] ++;
+    nsel++;
+  }
+  return nsel;
+}
+
+
+int EcalPhiSymHitBatch::accumulate(long long* etsumKeV, unsigned int* nhits,
+				   unsigned int& overflows) const {
+
+  int nsel=0;
+  for (int i=0; i<n; i++) {
+    if (!pass[i]) continue;
+    if (!EcalPhiSymAccumulator::addKeV(etsumKeV[hi[i]],
+				       EcalPhiSymAccumulator::toKeV(et[i])))
+      overflows++;
+    nhits[hi[i]] ++;
+    nsel++;
+  }
+  return nsel;
+}
+
+
+void EcalPhiSymHitBatch::accumulateMoments(double* esum, double* et2sum,
+					   double* e2sum) const {
+
+  for (int i=0; i<n; i++) {
+    if (!pass[i]) continue;
+    double ei = e[i], eti = et[i];
+    esum  [hi[i]] += ei;
+    et2sum[hi[i]] += eti*eti;
+    e2sum [hi[i]] += ei*ei;
+  }
+}
+
+
+void EcalPhiSymHitBatch::accumulateMoments(long long* esumKeV, long long* et2sumKeV,
+					   long long* e2sumKeV, unsigned int& overflows) const {
+
+  for (int i=0; i<n; i++) {
+    if (!pass[i]) continue;
+    double ei = e[i], eti = et[i];
+    if (!EcalPhiSymAccumulator::addKeV(esumKeV  [hi[i]], EcalPhiSymAccumulator::toKeV(ei)))
+      overflows++;
+    if (!EcalPhiSymAccumulator::addKeV(et2sumKeV[hi[i]], EcalPhiSymAccumulator::toKeV(eti*eti)))
+      overflows++;
+    if (!EcalPhiSymAccumulator::addKeV(e2sumKeV [hi[i]], EcalPhiSymAccumulator::toKeV(ei*ei)))
+      overflows++;
+  }
+}
@@ -0,0 +1,289 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitCache.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalGeomPhiSymHelper.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymLumiMask.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+  const char kMagic[4] = {'P','S','H','C'};
+
+  size_t padded(size_t n) { return (n+7) & ~size_t(7); }
+
+  /// bytes of the crystal table following the header
+  size_t tableSize(const phisym::HitCacheHeader& h){
+    return padded(4*(h.nBarl+h.nEndc+h.nRings) + 2*h.nEndc + h.nBarl + h.nEndc);
+  }
+
+  template <class T>
+  void writeArray(std::ofstream& out, const std::vector<T>& v){
+    if (!v.empty()) out.write(reinterpret_cast<const char*>(&v[0]), v.size()*sizeof(T));
+  }
+
+}
+
+
+const uint32_t EcalPhiSymHitCache::kVersion;
+
+
+//_____________________________________________________________________________
+
+EcalPhiSymHitCache::EcalPhiSymHitCache() :
+  buffer_(1<<20), nBarl_(0), run_(0), lumi_(0), events_(0) {}
+
+
+bool EcalPhiSymHitCache::open(const std::string& fileName,
+			      const EcalPhiSymCrystalTable& crystals,
+			      const EcalGeomPhiSymHelper& helper,
+			      float windowLow, float windowHigh){
+
+  out_.rdbuf()->pubsetbuf(&buffer_[0], buffer_.size());
+  out_.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out_) {
+    edm::LogError("PhiSym") << "Can't open hit cache " << fileName << std::endl;
+    return false;
+  }
+
+  phisym::HitCacheHeader header;
+  memcpy(header.magic, kMagic, 4);
+  header.version    = kVersion;
+  header.nBarl      = crystals.eta_barl_.size();
+  header.nEndc      = crystals.eta_endc_.size();
+  header.nRings     = crystals.etaRing_.size();
+  header.windowLow  = windowLow;
+  header.windowHigh = windowHigh;
+  header.reserved   = 0;
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  std::vector<uint8_t> status_barl(header.nBarl, 0);
+  for (unsigned int hi=0; hi<header.nBarl; hi++) {
+    EBDetId eb = EBDetId::unhashIndex(hi);
+    int sign = eb.zside()>0 ? 1 : 0;
+    status_barl[hi] = std::min(255, helper.statusCode_barl[abs(eb.ieta())-1][eb.iphi()-1][sign]);
+  }
+  std::vector<uint8_t> status_endc(header.nEndc, 0);
+  for (unsigned int hi=0; hi<header.nEndc; hi++) {
+    EEDetId ee = EEDetId::unhashIndex(hi);
+    int sign = ee.zside()>0 ? 1 : 0;
+    status_endc[hi] = std::min(255, helper.statusCode_endc[ee.ix()-1][ee.iy()-1][sign]);
+  }
+
+  writeArray(out_, crystals.eta_barl_);
+  writeArray(out_, crystals.eta_endc_);
+  writeArray(out_, crystals.etaRing_);
+  writeArray(out_, crystals.ring_endc_);
+  writeArray(out_, status_barl);
+  writeArray(out_, status_endc);
+
+  size_t written = 4*(header.nBarl+header.nEndc+header.nRings)
+    + 2*header.nEndc + header.nBarl + header.nEndc;
+  static const char zeros[8] = {0,0,0,0,0,0,0,0};
+  out_.write(zeros, tableSize(header)-written);
+
+  run_ = lumi_ = 0;
+  events_ = 0;
+  clear();
+  return true;
+}
+
+
+void EcalPhiSymHitCache::close(){
+
+  if (out_.is_open()) out_.close();
+}
+
+
+void EcalPhiSymHitCache::write(const edm::EventID& id){
+
+  if (!out_.is_open()) return;
+
+  if (id.run()!=run_ || id.luminosityBlock()!=lumi_) {
+    run_  = id.run();
+    lumi_ = id.luminosityBlock();
+    phisym::HitCacheRecord lumi = {phisym::HitCacheRecord::kLumi, run_, lumi_, 0, 0};
+    out_.write(reinterpret_cast<const char*>(&lumi), sizeof(lumi));
+  }
+
+  phisym::HitCacheRecord event = {phisym::HitCacheRecord::kEvent, nBarl_,
+				  uint32_t(hits_.size()-nBarl_), 0, id.event()};
+  out_.write(reinterpret_cast<const char*>(&event), sizeof(event));
+  writeArray(out_, hits_);
+  events_++;
+}
+
+
+//_____________________________________________________________________________
+
+EcalPhiSymHitCacheReader::EcalPhiSymHitCacheReader() :
+  data_(0), size_(0), begin_(0), header_(0),
+  eta_barl_(0), eta_endc_(0), ring_endc_(0),
+  status_barl_(0), status_endc_(0), etaRing_(0) {}
+
+
+EcalPhiSymHitCacheReader::~EcalPhiSymHitCacheReader(){
+
+  close();
+}
+
+
+bool EcalPhiSymHitCacheReader::open(const std::string& fileName){
+
+  close();
+
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd<0) {
+    edm::LogError("PhiSym") << "Can't open hit cache " << fileName << std::endl;
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st)!=0 || size_t(st.st_size)<sizeof(phisym::HitCacheHeader)) {
+    edm::LogError("PhiSym") << fileName << " is not a hit cache" << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  void* map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map==MAP_FAILED) {
+    edm::LogError("PhiSym") << "Can't map hit cache " << fileName << std::endl;
+    return false;
+  }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  data_ = static_cast<const char*>(map);
+  size_ = st.st_size;
+  header_ = reinterpret_cast<const phisym::HitCacheHeader*>(data_);
+
+  if (memcmp(header_->magic, kMagic, 4)!=0 || header_->version!=EcalPhiSymHitCache::kVersion ||
+      sizeof(phisym::HitCacheHeader)+tableSize(*header_) > size_) {
+    edm::LogError("PhiSym") << fileName << " is not a hit cache of version "
+			    << EcalPhiSymHitCache::kVersion << std::endl;
+    close();
+    return false;
+  }
+
+  const char* p = data_ + sizeof(phisym::HitCacheHeader);
+  eta_barl_    = reinterpret_cast<const float*>(p);   p += 4*header_->nBarl;
+  eta_endc_    = reinterpret_cast<const float*>(p);   p += 4*header_->nEndc;
+  etaRing_     = reinterpret_cast<const float*>(p);   p += 4*header_->nRings;
+  ring_endc_   = reinterpret_cast<const int16_t*>(p); p += 2*header_->nEndc;
+  status_barl_ = reinterpret_cast<const uint8_t*>(p); p += header_->nBarl;
+  status_endc_ = reinterpret_cast<const uint8_t*>(p);
+
+  begin_ = sizeof(phisym::HitCacheHeader) + tableSize(*header_);
+  return true;
+}
+
+
+void EcalPhiSymHitCacheReader::close(){
+
+  if (data_) munmap(const_cast<char*>(data_), size_);
+  data_ = 0;
+  size_ = begin_ = 0;
+  header_ = 0;
+}
+
+
+void EcalPhiSymHitCacheReader::table(EcalPhiSymCrystalTable& crystals,
+				     int statusThreshold, bool allChannels) const {
+
+  const int nBarl = header_->nBarl;
+  crystals.eta_barl_    .assign(eta_barl_, eta_barl_+nBarl);
+  crystals.invCosh_barl_.assign(nBarl, 0.);
+  crystals.eCut_barl_   .assign(nBarl, 0.);
+  crystals.etThr_barl_  .assign(nBarl, 0.);
+  crystals.ring_barl_   .assign(nBarl, -1);
+  crystals.sign_barl_   .assign(nBarl, 0);
+  crystals.good_barl_   .assign(nBarl, 0);
+  crystals.sel_barl_    .assign(nBarl, 0);
+
+  for (int hi=0; hi<nBarl; hi++) {
+    EBDetId eb = EBDetId::unhashIndex(hi);
+    crystals.invCosh_barl_[hi] = 1./cosh(eta_barl_[hi]);
+    crystals.ring_barl_[hi]    = abs(eb.ieta())-1;
+    crystals.sign_barl_[hi]    = eb.zside()>0 ? 1 : 0;
+    crystals.good_barl_[hi]    = status_barl_[hi] <= statusThreshold;
+    crystals.sel_barl_[hi]     = allChannels || crystals.good_barl_[hi];
+  }
+
+  const int nEndc = header_->nEndc;
+  crystals.eta_endc_    .assign(eta_endc_, eta_endc_+nEndc);
+  crystals.invCosh_endc_.assign(nEndc, 0.);
+  crystals.eCut_endc_   .assign(nEndc, 0.);
+  crystals.etThr_endc_  .assign(nEndc, 0.);
+  crystals.ring_endc_   .assign(ring_endc_, ring_endc_+nEndc);
+  crystals.sign_endc_   .assign(nEndc, 0);
+  crystals.good_endc_   .assign(nEndc, 0);
+  crystals.sel_endc_    .assign(nEndc, 0);
+
+  for (int hi=0; hi<nEndc; hi++) {
+    EEDetId ee = EEDetId::unhashIndex(hi);
+    bool inRing = ring_endc_[hi]!=-1;
+    crystals.invCosh_endc_[hi] = 1./cosh(eta_endc_[hi]);
+    crystals.sign_endc_[hi]    = ee.zside()>0 ? 1 : 0;
+    crystals.good_endc_[hi]    = inRing && status_endc_[hi] <= statusThreshold;
+    crystals.sel_endc_[hi]     = inRing && (allChannels || crystals.good_endc_[hi]);
+  }
+
+  crystals.etaRing_.assign(etaRing_, etaRing_+header_->nRings);
+}
+
+
+void EcalPhiSymHitCacheReader::setup(EcalPhiSymAccumulator& sums, int statusThreshold) const {
+
+  sums.setup(std::vector<short>(ring_endc_, ring_endc_+header_->nEndc),
+	     std::vector<unsigned char>(status_barl_, status_barl_+header_->nBarl),
+	     std::vector<unsigned char>(status_endc_, status_endc_+header_->nEndc),
+	     statusThreshold);
+}
+
+
+bool EcalPhiSymHitCacheReader::index(std::vector<size_t>& events, unsigned int& nlumis,
+				     const EcalPhiSymLumiMask* mask,
+				     unsigned long long* nskipped) const {
+
+  events.clear();
+  nlumis = 0;
+  bool accept = true;
+
+  size_t offset = begin_;
+  while (offset + sizeof(phisym::HitCacheRecord) <= size_) {
+    const phisym::HitCacheRecord& r = record(offset);
+    if (r.type==phisym::HitCacheRecord::kLumi) {
+      nlumis++;
+      accept = !mask || mask->accept(r.a, r.b);
+      offset += sizeof(phisym::HitCacheRecord);
+    } else if (r.type==phisym::HitCacheRecord::kEvent) {
+      size_t next = offset + sizeof(phisym::HitCacheRecord)
+	+ (size_t(r.a)+r.b)*sizeof(phisym::HitCacheHit);
+      if (next > size_) break;
+      if (accept) events.push_back(offset);
+      else if (nskipped) (*nskipped)++;
+      offset = next;
+    } else {
+      break;
+    }
+  }
+
+  if (offset!=size_) {
+    edm::LogError("PhiSym") << "Hit cache truncated or corrupt at byte " << offset
+			    << " of " << size_ << std::endl;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,106 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymLumiMask.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+
+bool EcalPhiSymLumiMask::load(const std::string& fileName){
+
+  // a mask that can't be read rejects all events
+  active_=true;
+  ranges_.clear();
+
+  std::ifstream in(fileName.c_str(), std::ios::in);
+  if (!in) {
+    edm::LogError("PhiSym") << "Can't open lumi mask " << fileName << std::endl;
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const std::string text = buffer.str();
+
+  // "run" keys at depth 1, [first, last] pairs at depth 3
+  std::vector<Range> ranges;
+  int depth=0;
+  unsigned int run=0;
+  bool haveRun=false;
+  std::vector<unsigned long> pair;
+  bool ok=true;
+
+  for (size_t i=0; i<text.size() && ok; i++) {
+    char c = text[i];
+    if (c=='"') {
+      size_t end = text.find('"', i+1);
+      if (end==std::string::npos || depth!=1) { ok=false; break; }
+      char* stop;
+      run = strtoul(text.c_str()+i+1, &stop, 10);
+      haveRun = stop==text.c_str()+end && end>i+1;
+      ok = haveRun;
+      i = end;
+    } else if (c=='[') {
+      depth++;
+      if (depth==3) pair.clear();
+      ok = depth<=3 && haveRun;
+    } else if (c==']') {
+      if (depth==3) {
+	ok = pair.size()==2 && pair[0]<=pair[1];
+	if (ok) {
+	  Range r = {run, unsigned(pair[0]), unsigned(pair[1])};
+	  ranges.push_back(r);
+	}
+      }
+      depth--;
+    } else if (c=='{') {
+      depth++;
+      ok = depth==1;
+    } else if (c=='}') {
+      depth--;
+    } else if (isdigit(c)) {
+      char* stop;
+      unsigned long n = strtoul(text.c_str()+i, &stop, 10);
+      ok = depth==3 && pair.size()<2;
+      pair.push_back(n);
+      i = stop-text.c_str()-1;
+    } else if (c==':' || c==',' || isspace(c)) {
+      continue;
+    } else {
+      ok=false;
+    }
+  }
+
+  if (!ok || depth!=0) {
+    edm::LogError("PhiSym") << "Can't parse lumi mask " << fileName << std::endl;
+    return false;
+  }
+
+  // sort and merge overlapping or adjacent ranges of a run
+  std::sort(ranges.begin(), ranges.end());
+  for (unsigned int i=0; i<ranges.size(); i++) {
+    if (!ranges_.empty() && ranges_.back().run==ranges[i].run &&
+	ranges[i].first <= ranges_.back().last+1)
+      ranges_.back().last = std::max(ranges_.back().last, ranges[i].last);
+    else
+      ranges_.push_back(ranges[i]);
+  }
+
+  return true;
+}
+
+
+bool EcalPhiSymLumiMask::accept(unsigned int run, unsigned int lumi) const {
+
+  if (!active_) return true;
+
+  // last range starting at or before (run, lumi)
+  Range key = {run, lumi, lumi};
+  std::vector<Range>::const_iterator it =
+    std::upper_bound(ranges_.begin(), ranges_.end(), key);
+  if (it==ranges_.begin()) return false;
+  --it;
+  return it->run==run && lumi<=it->last;
+}
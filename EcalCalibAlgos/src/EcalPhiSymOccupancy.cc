@@ -0,0 +1,178 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymOccupancy.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCrystalTable.h"
+
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+namespace {
+
+  // barrel rings of both sides, then endcap rings
+  const int kRings = kSides*(kBarlRings+kEndcEtaRings);
+
+}
+
+
+EcalPhiSymOccupancy::EcalPhiSymOccupancy() :
+  nSigma_(0.), minHits_(1.), exclude_(false), flagStatus_(0) {}
+
+
+void EcalPhiSymOccupancy::configure(double nSigma, double minHits, bool exclude,
+				    int flagStatus){
+
+  nSigma_     = nSigma;
+  minHits_    = std::max(minHits, 1.);
+  exclude_    = exclude;
+  flagStatus_ = std::min(std::max(flagStatus, 0), 255);
+}
+
+
+void EcalPhiSymOccupancy::setBaseline(const EcalPhiSymAccumulator& sums){
+
+  last_ = sums.nhits_barl_;
+  last_.insert(last_.end(), sums.nhits_endc_.begin(), sums.nhits_endc_.end());
+}
+
+
+EcalPhiSymOccupancy::Flag EcalPhiSymOccupancy::test(double n, double mean) const {
+
+  if (mean<minHits_) return kNone;
+  double pull = (n-mean)/sqrt(mean);
+  if (pull >  nSigma_) return kHot;
+  if (pull < -nSigma_) return kDead;
+  return kNone;
+}
+
+
+//_____________________________________________________________________________
+
+int EcalPhiSymOccupancy::check(const edm::LuminosityBlock& lb,
+			       const EcalPhiSymAccumulator& sums,
+			       const EcalPhiSymCrystalTable& crystals){
+
+  if (!active()) return 0;
+
+  int nbarl  = sums.nhits_barl_.size();
+  int ncells = nbarl + sums.nhits_endc_.size();
+  last_.resize(ncells, 0);
+  flag_.resize(ncells, kNone);
+
+  // hits of the lumi section
+  std::vector<double> hits(ncells);
+  for (int i=0; i<ncells; i++) {
+    unsigned int nhits = i<nbarl ? sums.nhits_barl_[i] : sums.nhits_endc_[i-nbarl];
+    hits[i] = nhits - last_[i];
+    last_[i] = nhits;
+  }
+
+  // no event seen yet
+  if (crystals.good_barl_.empty()) return 0;
+
+  // ring of the crystals entering the means, good and not flagged;
+  // -1 for the others
+  std::vector<int> ring(ncells, -1);
+  std::vector<double> ringHits(kRings, 0.);
+  std::vector<int> ringCells(kRings, 0);
+  for (int i=0; i<ncells; i++) {
+    if (flag_[i]) continue;
+    if (i<nbarl) {
+      if (!crystals.good_barl_[i]) continue;
+      ring[i] = crystals.sign_barl_[i]*kBarlRings + crystals.ring_barl_[i];
+    } else {
+      int hi = i-nbarl;
+      if (!crystals.good_endc_[hi] || crystals.ring_endc_[hi]==-1) continue;
+      ring[i] = kSides*kBarlRings + crystals.sign_endc_[hi]*kEndcEtaRings + crystals.ring_endc_[hi];
+    }
+    ringHits[ring[i]] += hits[i];
+    ringCells[ring[i]]++;
+  }
+
+  std::vector<unsigned char> flag(ncells, kNone);
+  std::vector<bool> byTower(ncells, false);
+  std::vector<double> expected(ncells, 0.);
+
+  for (int t=0; t<towers_.nTowers(); t++) {
+    int offset = towers_.isBarl(t) ? 0 : nbarl;
+
+    double towerHits=0.;
+    int towerCells=0;
+    for (const int* hi=towers_.begin(t); hi!=towers_.end(t); hi++) {
+      if (ring[offset+*hi]<0) continue;
+      towerHits += hits[offset+*hi];
+      towerCells++;
+    }
+    if (!towerCells) continue;
+
+    // each crystal against the other crystals of its tower and ring
+    for (const int* hi=towers_.begin(t); hi!=towers_.end(t); hi++) {
+      int i = offset+*hi;
+      int r = ring[i];
+      if (r<0 || towerCells<2 || ringCells[r]<2) continue;
+      double towerMean = (towerHits-hits[i])/(towerCells-1);
+      double ringMean  = (ringHits[r]-hits[i])/(ringCells[r]-1);
+      Flag f = test(hits[i], towerMean);
+      if (f!=kNone && test(hits[i], ringMean)==f) {
+	flag[i] = f;
+	expected[i] = towerMean;
+      }
+    }
+
+    // the rest of the tower against the means of their rings
+    double restHits=0., restExpected=0.;
+    for (const int* hi=towers_.begin(t); hi!=towers_.end(t); hi++) {
+      int i = offset+*hi;
+      if (ring[i]<0 || flag[i]) continue;
+      restHits     += hits[i];
+      restExpected += ringHits[ring[i]]/ringCells[ring[i]];
+    }
+    Flag f = test(restHits, restExpected);
+    if (f==kNone) continue;
+    for (const int* hi=towers_.begin(t); hi!=towers_.end(t); hi++) {
+      int i = offset+*hi;
+      if (ring[i]<0 || flag[i]) continue;
+      flag[i] = f;
+      byTower[i] = true;
+      expected[i] = ringHits[ring[i]]/ringCells[ring[i]];
+    }
+  }
+
+  int nflagged=0;
+  for (int i=0; i<ncells; i++) {
+    if (!flag[i]) continue;
+    flag_[i] = flag[i];
+    nflagged++;
+
+    std::cout << "PHIFLAG : run " << lb.run() << " id " << lb.id();
+    if (i<nbarl) {
+      EBDetId eb = EBDetId::unhashIndex(i);
+      std::cout << " EB ieta " << eb.ieta() << " iphi " << eb.iphi();
+    } else {
+      EEDetId ee = EEDetId::unhashIndex(i-nbarl);
+      std::cout << " EE ix " << ee.ix() << " iy " << ee.iy() << " side " << ee.zside();
+    }
+    std::cout << (flag[i]==kHot ? " hot" : " dead")
+	      << (byTower[i] ? " tower" : " crystal")
+	      << " hits " << hits[i] << " expected " << expected[i] << std::endl;
+  }
+
+  return nflagged;
+}
+
+
+void EcalPhiSymOccupancy::applyFlags(EcalPhiSymAccumulator& sums) const {
+
+  if (!exclude_) return;
+
+  unsigned int nbarl = sums.status_barl_.size();
+  for (unsigned int i=0; i<flag_.size(); i++) {
+    if (!flag_[i]) continue;
+    unsigned char& status = i<nbarl ? sums.status_barl_[i] : sums.status_endc_[i-nbarl];
+    status = std::max<int>(status, flagStatus_);
+  }
+}
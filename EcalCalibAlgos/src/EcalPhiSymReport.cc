@@ -0,0 +1,74 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymReport.h"
+
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+
+void phisym::ReportCounts::add(const ReportCounts& other){
+
+  events        += other.events;
+  passed        += other.passed;
+  skipped       += other.skipped;
+  resumed       += other.resumed;
+  hits_barl     += other.hits_barl;
+  selected_barl += other.selected_barl;
+  hits_endc     += other.hits_endc;
+  selected_endc += other.selected_endc;
+  wall          += other.wall;
+  cpu           += other.cpu;
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymReport::writeLumi(const edm::LuminosityBlock& lb,
+				 const phisym::ReportCounts& counts, size_t memory){
+
+  write("lumi", lb.run(), lb.luminosityBlock(),
+	lb.beginTime().value()>>32, lb.endTime().value()>>32, counts, memory);
+}
+
+
+void EcalPhiSymReport::writeRun(const edm::Run& run,
+				const phisym::ReportCounts& counts, size_t memory){
+
+  write("run", run.run(), 0,
+	run.beginTime().value()>>32, run.endTime().value()>>32, counts, memory);
+}
+
+
+void EcalPhiSymReport::write(const char* type, unsigned int run, unsigned int lumi,
+			     unsigned long long start, unsigned long long end,
+			     const phisym::ReportCounts& counts, size_t memory){
+
+  if (!active()) return;
+
+  if (!out_.is_open()) {
+    out_.open(fileName_.c_str(), std::ios::out | std::ios::app);
+    if (!out_) {
+      edm::LogError("PhiSym") << "Can't open report " << fileName_
+			      << ", not reporting" << std::endl;
+      fileName_.clear();
+      return;
+    }
+  }
+
+  unsigned long long hits = counts.hits_barl + counts.hits_endc;
+
+  out_ << "{\"type\":\"" << type << "\",\"run\":" << run;
+  if (lumi) out_ << ",\"lumi\":" << lumi;
+  out_ << ",\"start\":" << start << ",\"end\":" << end << ",\"dur\":" << end-start
+       << ",\"events\":" << counts.events
+       << ",\"passed\":" << counts.passed
+       << ",\"skipped\":" << counts.skipped
+       << ",\"resumed\":" << counts.resumed
+       << ",\"hitsEB\":" << counts.hits_barl
+       << ",\"selectedEB\":" << counts.selected_barl
+       << ",\"hitsEE\":" << counts.hits_endc
+       << ",\"selectedEE\":" << counts.selected_endc
+       << ",\"wall\":" << counts.wall
+       << ",\"cpu\":" << counts.cpu
+       << ",\"hitsPerSec\":" << (counts.wall>0. ? hits/counts.wall : 0.)
+       << ",\"memory\":" << memory << "}" << std::endl;
+}
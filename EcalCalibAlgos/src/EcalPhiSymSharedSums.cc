@@ -0,0 +1,348 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymSharedSums.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymAccumulator.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+
+#include <algorithm>
+#include <ctime>
+#include <cstring>
+#include <ostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+  const uint32_t kMagic = 0x50535348;   // "PSSH"
+  const uint32_t kBusy  = 1;            // being set up
+
+  void atomicAdd(double* sum, double x){
+    uint64_t* bits = reinterpret_cast<uint64_t*>(sum);
+    uint64_t old = __atomic_load_n(bits, __ATOMIC_RELAXED);
+    uint64_t next;
+    do {
+      double value;
+      memcpy(&value, &old, sizeof(value));
+      value += x;
+      memcpy(&next, &value, sizeof(next));
+    } while (!__atomic_compare_exchange_n(bits, &old, next, true,
+					  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  }
+
+  void atomicAdd(int64_t* sum, long long x){
+    __atomic_fetch_add(sum, int64_t(x), __ATOMIC_RELAXED);
+  }
+
+  void atomicAdd(uint32_t* sum, unsigned int x){
+    __atomic_fetch_add(sum, uint32_t(x), __ATOMIC_RELAXED);
+  }
+
+  void atomicMax(unsigned char* status, unsigned char x){
+    unsigned char old = __atomic_load_n(status, __ATOMIC_RELAXED);
+    while (x>old && !__atomic_compare_exchange_n(status, &old, x, true,
+						 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+  }
+
+  /// add the change of a barrel and endcap column since last
+  template <class S, class T>
+  void mergeColumn(S* shared, const std::vector<T>& barl, const std::vector<T>& endc,
+		   std::vector<T>& last){
+    unsigned int nbarl = barl.size();
+    for (unsigned int i=0; i<last.size(); i++) {
+      T value = i<nbarl ? barl[i] : endc[i-nbarl];
+      if (value!=last[i]) atomicAdd(shared+i, value-last[i]);
+      last[i] = value;
+    }
+  }
+
+  template <class S, class T>
+  void loadColumn(const S* shared, std::vector<T>& barl, std::vector<T>& endc){
+    unsigned int nbarl = barl.size();
+    for (unsigned int i=0; i<nbarl; i++) barl[i] = shared[i];
+    for (unsigned int i=0; i<endc.size(); i++) endc[i] = shared[nbarl+i];
+  }
+
+}
+
+
+const uint32_t EcalPhiSymSharedSums::kVersion;
+
+
+EcalPhiSymSharedSums::EcalPhiSymSharedSums() :
+  header_(0), size_(0),
+  etsum_(0), etsumKeV_(0), esum_(0), et2sum_(0), e2sum_(0),
+  esumKeV_(0), et2sumKeV_(0), e2sumKeV_(0),
+  nhits_(0), ring_endc_(0), status_(0) {}
+
+
+EcalPhiSymSharedSums::~EcalPhiSymSharedSums(){
+
+  unmap();
+}
+
+
+size_t EcalPhiSymSharedSums::size(uint32_t nbarl, uint32_t nendc){
+
+  size_t n = nbarl+nendc;
+  return sizeof(Header) + n*(4*sizeof(double) + sizeof(int64_t) + sizeof(uint32_t) + 1)
+    + nendc*sizeof(int16_t);
+}
+
+
+//_____________________________________________________________________________
+
+bool EcalPhiSymSharedSums::attach(const std::string& name, bool fixedPoint,
+				  unsigned int expected, bool readOnly){
+
+  unmap();
+
+  if (!readOnly && expected==0) {
+    edm::LogError("PhiSym") << "Shared sums " << name << " need the number of processes "
+			    << "sharing them, not attached" << std::endl;
+    return false;
+  }
+
+  uint32_t nbarl = EBDetId::kSizeForDenseIndexing;
+  uint32_t nendc = EEDetId::kSizeForDenseIndexing;
+  size_t bytes = size(nbarl, nendc);
+
+  int fd = shm_open(name.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT, 0600);
+  struct stat st;
+  if (fd<0 || fstat(fd, &st)!=0) {
+    edm::LogError("PhiSym") << "Can't open shared sums " << name << std::endl;
+    if (fd>=0) close(fd);
+    return false;
+  }
+
+  // a new segment is empty until one of its processes sizes it
+  if (!readOnly && st.st_size==0 && ftruncate(fd, bytes)==0) st.st_size = bytes;
+  if (size_t(st.st_size)!=bytes) {
+    edm::LogError("PhiSym") << "Shared sums " << name << " have " << st.st_size
+			    << " bytes instead of " << bytes << std::endl;
+    close(fd);
+    return false;
+  }
+
+  void* base = mmap(0, bytes, readOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+		    MAP_SHARED, fd, 0);
+  close(fd);
+  if (base==MAP_FAILED) {
+    edm::LogError("PhiSym") << "Can't map shared sums " << name << std::endl;
+    return false;
+  }
+
+  Header* header = static_cast<Header*>(base);
+  uint32_t zero = 0;
+  if (!readOnly && __atomic_compare_exchange_n(&header->magic, &zero, kBusy, false,
+					       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    header->version    = kVersion;
+    header->nbarl      = nbarl;
+    header->nendc      = nendc;
+    header->fixedPoint = fixedPoint;
+    header->expected   = expected;
+    __atomic_store_n(&header->magic, kMagic, __ATOMIC_RELEASE);
+  }
+
+  // wait for the process setting it up
+  for (int i=0; i<1000 && __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE)==kBusy; i++)
+    usleep(1000);
+
+  if (header->magic!=kMagic || header->version!=kVersion ||
+      header->nbarl!=nbarl || header->nendc!=nendc) {
+    edm::LogError("PhiSym") << name << " are not shared sums of version " << kVersion
+			    << std::endl;
+    munmap(base, bytes);
+    return false;
+  }
+  if (!readOnly && bool(header->fixedPoint)!=fixedPoint) {
+    edm::LogError("PhiSym") << "Shared sums " << name << " were created with fixedPointSums "
+			    << bool(header->fixedPoint) << std::endl;
+    munmap(base, bytes);
+    return false;
+  }
+  if (!readOnly && header->expected!=expected) {
+    edm::LogError("PhiSym") << "Shared sums " << name << " were created for "
+			    << header->expected << " processes" << std::endl;
+    munmap(base, bytes);
+    return false;
+  }
+
+  name_ = name;
+  header_ = header;
+  size_ = bytes;
+  map(static_cast<char*>(base));
+
+  if (!readOnly) {
+    size_t n = nbarl+nendc;
+    lastEtsum_.assign(n, 0.);
+    lastEsum_.assign(n, 0.);
+    lastEt2sum_.assign(n, 0.);
+    lastE2sum_.assign(n, 0.);
+    if (fixedPoint) {
+      lastEtsumKeV_.assign(n, 0);
+      lastEsumKeV_.assign(n, 0);
+      lastEt2sumKeV_.assign(n, 0);
+      lastE2sumKeV_.assign(n, 0);
+    }
+    lastNhits_.assign(n, 0);
+    __atomic_fetch_add(&header_->attached, 1, __ATOMIC_ACQ_REL);
+  }
+  return true;
+}
+
+
+void EcalPhiSymSharedSums::map(char* base){
+
+  size_t n = header_->nbarl + header_->nendc;
+  char* p = base + sizeof(Header);
+
+  etsum_     = reinterpret_cast<double*>(p);  p += n*sizeof(double);
+  etsumKeV_  = reinterpret_cast<int64_t*>(p); p += n*sizeof(int64_t);
+  esum_      = reinterpret_cast<double*>(p);  p += n*sizeof(double);
+  et2sum_    = reinterpret_cast<double*>(p);  p += n*sizeof(double);
+  e2sum_     = reinterpret_cast<double*>(p);  p += n*sizeof(double);
+  nhits_     = reinterpret_cast<uint32_t*>(p); p += n*sizeof(uint32_t);
+  ring_endc_ = reinterpret_cast<int16_t*>(p); p += header_->nendc*sizeof(int16_t);
+  status_    = reinterpret_cast<unsigned char*>(p);
+
+  esumKeV_   = reinterpret_cast<int64_t*>(esum_);
+  et2sumKeV_ = reinterpret_cast<int64_t*>(et2sum_);
+  e2sumKeV_  = reinterpret_cast<int64_t*>(e2sum_);
+}
+
+
+void EcalPhiSymSharedSums::unmap(){
+
+  if (header_) munmap(header_, size_);
+  header_ = 0;
+  size_ = 0;
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymSharedSums::setRings(const std::vector<short>& ring_endc){
+
+  if (!active() || __atomic_load_n(&header_->hasRings, __ATOMIC_ACQUIRE)) return;
+
+  // the same for every process, whichever writes them
+  for (unsigned int hi=0; hi<header_->nendc && hi<ring_endc.size(); hi++)
+    ring_endc_[hi] = ring_endc[hi];
+  __atomic_store_n(&header_->hasRings, 1, __ATOMIC_RELEASE);
+}
+
+
+void EcalPhiSymSharedSums::merge(const EcalPhiSymAccumulator& sums){
+
+  if (!active() || lastNhits_.empty()) return;
+
+  if (header_->fixedPoint) {
+    mergeColumn(etsumKeV_,  sums.etsumKeV_barl_,  sums.etsumKeV_endc_,  lastEtsumKeV_);
+    mergeColumn(esumKeV_,   sums.esumKeV_barl_,   sums.esumKeV_endc_,   lastEsumKeV_);
+    mergeColumn(et2sumKeV_, sums.et2sumKeV_barl_, sums.et2sumKeV_endc_, lastEt2sumKeV_);
+    mergeColumn(e2sumKeV_,  sums.e2sumKeV_barl_,  sums.e2sumKeV_endc_,  lastE2sumKeV_);
+  } else {
+    mergeColumn(etsum_,  sums.etsum_barl_,  sums.etsum_endc_,  lastEtsum_);
+    mergeColumn(esum_,   sums.esum_barl_,   sums.esum_endc_,   lastEsum_);
+    mergeColumn(et2sum_, sums.et2sum_barl_, sums.et2sum_endc_, lastEt2sum_);
+    mergeColumn(e2sum_,  sums.e2sum_barl_,  sums.e2sum_endc_,  lastE2sum_);
+  }
+  mergeColumn(nhits_,  sums.nhits_barl_,  sums.nhits_endc_,  lastNhits_);
+
+  unsigned int nbarl = sums.status_barl_.size();
+  for (unsigned int i=0; i<nbarl; i++) atomicMax(status_+i, sums.status_barl_[i]);
+  for (unsigned int i=0; i<sums.status_endc_.size(); i++)
+    atomicMax(status_+nbarl+i, sums.status_endc_[i]);
+
+  __atomic_fetch_add(&header_->merges, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&header_->lastMerge, int64_t(time(0)), __ATOMIC_RELAXED);
+}
+
+
+bool EcalPhiSymSharedSums::detach(EcalPhiSymAccumulator& sums){
+
+  if (!active() || lastNhits_.empty()) return false;
+
+  merge(sums);
+
+  uint32_t detached = __atomic_add_fetch(&header_->detached, 1, __ATOMIC_ACQ_REL);
+  bool last = detached>=header_->expected;
+
+  if (last) {
+    // rings and good cells set up again by the caller
+    load(sums, 255);
+    remove(name_);
+  }
+
+  unmap();
+  lastNhits_.clear();
+  return last;
+}
+
+
+void EcalPhiSymSharedSums::load(EcalPhiSymAccumulator& sums, int statusThreshold) const {
+
+  if (!active()) return;
+
+  if (header_->fixedPoint && sums.fixedPoint()) {
+    loadColumn(etsumKeV_,  sums.etsumKeV_barl_,  sums.etsumKeV_endc_);
+    loadColumn(esumKeV_,   sums.esumKeV_barl_,   sums.esumKeV_endc_);
+    loadColumn(et2sumKeV_, sums.et2sumKeV_barl_, sums.et2sumKeV_endc_);
+    loadColumn(e2sumKeV_,  sums.e2sumKeV_barl_,  sums.e2sumKeV_endc_);
+    sums.updateEtSums();
+  } else {
+    loadColumn(etsum_,  sums.etsum_barl_,  sums.etsum_endc_);
+    loadColumn(esum_,   sums.esum_barl_,   sums.esum_endc_);
+    loadColumn(et2sum_, sums.et2sum_barl_, sums.et2sum_endc_);
+    loadColumn(e2sum_,  sums.e2sum_barl_,  sums.e2sum_endc_);
+  }
+  loadColumn(nhits_,  sums.nhits_barl_,  sums.nhits_endc_);
+
+  std::vector<unsigned char> status_barl(status_, status_+header_->nbarl);
+  std::vector<unsigned char> status_endc(status_+header_->nbarl,
+					 status_+header_->nbarl+header_->nendc);
+
+  if (__atomic_load_n(&header_->hasRings, __ATOMIC_ACQUIRE)) {
+    std::vector<short> ring_endc(ring_endc_, ring_endc_+header_->nendc);
+    sums.setup(ring_endc, status_barl, status_endc, statusThreshold);
+  } else {
+    for (unsigned int hi=0; hi<sums.status_barl_.size(); hi++)
+      sums.status_barl_[hi] = std::max(sums.status_barl_[hi], status_barl[hi]);
+    for (unsigned int hi=0; hi<sums.status_endc_.size(); hi++)
+      sums.status_endc_[hi] = std::max(sums.status_endc_[hi], status_endc[hi]);
+  }
+}
+
+
+void EcalPhiSymSharedSums::print(std::ostream& out) const {
+
+  if (!active()) return;
+
+  unsigned long long hits_barl=0, hits_endc=0;
+  double etsum_barl=0., etsum_endc=0.;
+  for (unsigned int i=0; i<header_->nbarl+header_->nendc; i++) {
+    double etsum = header_->fixedPoint ? etsumKeV_[i]*1e-6 : etsum_[i];
+    if (i<header_->nbarl) { hits_barl += nhits_[i]; etsum_barl += etsum; }
+    else                  { hits_endc += nhits_[i]; etsum_endc += etsum; }
+  }
+
+  out << "PHISHARED : " << name_
+      << " attached " << header_->attached
+      << " detached " << header_->detached
+      << " expected " << header_->expected
+      << " merges "   << header_->merges
+      << " last "     << header_->lastMerge
+      << " hitsEB "   << hits_barl << " etsumEB " << etsum_barl
+      << " hitsEE "   << hits_endc << " etsumEE " << etsum_endc << std::endl;
+}
+
+
+bool EcalPhiSymSharedSums::remove(const std::string& name){
+
+  return shm_unlink(name.c_str())==0;
+}
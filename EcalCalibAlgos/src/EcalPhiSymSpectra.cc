@@ -0,0 +1,115 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymSpectra.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCheckpoint.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "TFile.h"
+#include "TH1F.h"
+
+const double EcalPhiSymSpectra::kMaxBarl = 500.;
+const double EcalPhiSymSpectra::kMaxEndc = 1500.;
+
+
+namespace {
+
+  void writeHisto(const std::string& name, const char* title,
+		  const unsigned long long* counts, int nbins, double max){
+
+    TH1F h(name.c_str(), title, nbins, 0., max);
+    double entries=0.;
+    for (int ibin=0; ibin<nbins+2; ibin++) {
+      h.SetBinContent(ibin, counts[ibin]);
+      entries += counts[ibin];
+    }
+    h.SetEntries(entries);
+    // mean and RMS from the bin contents
+    h.ResetStats();
+    h.Write();
+  }
+
+}
+
+
+void EcalPhiSymSpectra::book(){
+
+  et_barl_.assign(kBarlRings*kSides*(kBinsBarl+2), 0);
+  e_barl_ .assign(kBarlRings*kSides*(kBinsBarl+2), 0);
+  et_endc_.assign(kEndcEtaRings*kSides*(kBinsEndc+2), 0);
+  e_endc_ .assign(kEndcEtaRings*kSides*(kBinsEndc+2), 0);
+}
+
+
+void EcalPhiSymSpectra::reset(){
+
+  std::fill(et_barl_.begin(), et_barl_.end(), 0);
+  std::fill(e_barl_ .begin(), e_barl_ .end(), 0);
+  std::fill(et_endc_.begin(), et_endc_.end(), 0);
+  std::fill(e_endc_ .begin(), e_endc_ .end(), 0);
+}
+
+
+void EcalPhiSymSpectra::add(const EcalPhiSymSpectra& other){
+
+  if (!booked() || !other.booked()) return;
+
+  for (unsigned int i=0; i<et_barl_.size(); i++) {
+    et_barl_[i] += other.et_barl_[i];
+    e_barl_ [i] += other.e_barl_ [i];
+  }
+  for (unsigned int i=0; i<et_endc_.size(); i++) {
+    et_endc_[i] += other.et_endc_[i];
+    e_endc_ [i] += other.e_endc_ [i];
+  }
+}
+
+
+void EcalPhiSymSpectra::writeState(std::ostream& out) const {
+
+  phisym::writeVector(out, et_barl_);
+  phisym::writeVector(out, e_barl_);
+  phisym::writeVector(out, et_endc_);
+  phisym::writeVector(out, e_endc_);
+}
+
+
+bool EcalPhiSymSpectra::readState(std::istream& in){
+
+  return
+    phisym::readVector(in, et_barl_) && phisym::readVector(in, e_barl_) &&
+    phisym::readVector(in, et_endc_) && phisym::readVector(in, e_endc_);
+}
+
+
+void EcalPhiSymSpectra::write(const std::string& fileName) const {
+
+  TFile f(fileName.c_str(),"recreate");
+
+  std::ostringstream t;
+  for (int sign=0; sign<kSides; sign++) {
+    for (int ieta=0; ieta<kBarlRings; ieta++) {
+      int offset = (ieta*kSides+sign)*(kBinsBarl+2);
+
+      t << "et_spectrum_b_" << ieta+1 << "_" << sign;
+      writeHisto(t.str(), ";E_{T} [MeV]", &et_barl_[offset], kBinsBarl, kMaxBarl);
+      t.str("");
+
+      t << "e_spectrum_b_" << ieta+1 << "_" << sign;
+      writeHisto(t.str(), ";E [MeV]", &e_barl_[offset], kBinsBarl, kMaxBarl);
+      t.str("");
+    }
+    for (int ring=0; ring<kEndcEtaRings; ring++) {
+      int offset = (ring*kSides+sign)*(kBinsEndc+2);
+
+      t << "et_spectrum_e_" << ring+1 << "_" << sign;
+      writeHisto(t.str(), ";E_{T} [MeV]", &et_endc_[offset], kBinsEndc, kMaxEndc);
+      t.str("");
+
+      t << "e_spectrum_e_" << ring+1 << "_" << sign;
+      writeHisto(t.str(), ";E [MeV]", &e_endc_[offset], kBinsEndc, kMaxEndc);
+      t.str("");
+    }
+  }
+
+  f.Close();
+}
@@ -0,0 +1,1045 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Algo.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymHitBatch.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymConvergence.h"
+#include "PhiSym/EcalCalibDataFormats/interface/EcalPhiSymLumiSums.h"
+
+// Framework
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/UnixSignalHandlers.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "CondFormats/DataRecord/interface/EcalIntercalibConstantsRcd.h"
+#include "CondTools/Ecal/interface/EcalIntercalibConstantsXMLTranslator.h"
+
+// Geometry
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+
+//Channel status
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+
+using namespace std;
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "TFile.h"
+#include "TH1F.h"
+#include "TF1.h"
+#include "TGraph.h"
+#include "TCanvas.h"
+
+const float EcalPhiSymStep1Algo::kMiscalRangeEB = .05;
+const float EcalPhiSymStep1Algo::kMiscalRangeEE = .10;
+
+
+EcalPhiSymStep1Algo::EcalPhiSymStep1Algo(const edm::ParameterSet& iConfig, bool forceFixedPoint) :
+
+  helperSource_(iConfig),
+  jobStatus_barl_(EBDetId::kSizeForDenseIndexing, 0),
+  jobStatus_endc_(EEDetId::kSizeForDenseIndexing, 0),
+  eCut_barl_( iConfig.getParameter< double > ("eCut_barrel") ),
+  ap_( iConfig.getParameter<double> ("ap") ),
+  b_( iConfig.getParameter<double> ("b") ), 
+  nSubsets_(iConfig.getUntrackedParameter<int>("nSubsets",0)),
+  bins_(iConfig.getUntrackedParameter<edm::ParameterSet>("binning",edm::ParameterSet())),
+  eventSet_( iConfig.getParameter< int > ("eventSet") ),
+  statusThreshold_(iConfig.getUntrackedParameter<int>("statusThreshold",3)),
+  allChannels_(iConfig.getUntrackedParameter<bool>("accumulateAllChannels",true)),
+  reiteration_(iConfig.getUntrackedParameter< bool > ("reiteration",false)),
+  oldcalibfile_(iConfig.getUntrackedParameter<std::string>("oldcalibfile",
+                                            "EcalintercalibConstants.xml")),
+  spectraFile_(iConfig.getUntrackedParameter<std::string>("spectraFile","Espectra.root")),
+  fixedPoint_(forceFixedPoint || iConfig.getUntrackedParameter<bool>("fixedPointSums",false)),
+  energyHistos_(iConfig.getUntrackedParameter<bool>("energyHistos",false)),
+  energyHistoBins_(iConfig.getUntrackedParameter<int>("energyHistoBins",128)),
+  energyHistoRangeEB_(iConfig.getUntrackedParameter<std::vector<double> >("energyHistoRangeEB",
+									  std::vector<double>{0.1, 2.5})),
+  energyHistoRangeEE_(iConfig.getUntrackedParameter<std::vector<double> >("energyHistoRangeEE",
+									  std::vector<double>{0.05, 2.0})),
+  hitCache_(iConfig.getUntrackedParameter<bool>("hitCache",false)),
+  hitCacheWindow_(iConfig.getUntrackedParameter<std::vector<double> >("hitCacheWindow",
+								      std::vector<double>{0.5, 2.0})),
+  trackConvergence_(iConfig.getUntrackedParameter<bool>("reportConvergence",false)),
+  targetPrecision_(iConfig.getUntrackedParameter<double>("targetPrecision",0.)),
+  stopAtPrecision_(iConfig.getUntrackedParameter<bool>("stopAtPrecision",false)),
+  isSetUp_(false)
+{
+
+  if (forceFixedPoint && !iConfig.getUntrackedParameter<bool>("fixedPointSums",false))
+    edm::LogInfo("PhiSym") << "Sums in integer keV, as with fixedPointSums, so that "
+			   << "they do not depend on the order of the events" << endl;
+
+  // events of other lumi sections are skipped before the hit loops
+  std::string lumiMask = iConfig.getUntrackedParameter<std::string>("lumiMask","");
+  if (!lumiMask.empty() && lumiMask_.load(lumiMask))
+    edm::LogInfo("PhiSym") << "Lumi mask " << lumiMask << ": "
+			   << lumiMask_.size() << " ranges" << endl;
+
+  // JSON lines report per lumi section and run
+  report_.configure(iConfig.getUntrackedParameter<std::string>("reportFile",""));
+
+  // hot and dead crystals flagged per lumi section
+  occupancy_.configure(iConfig.getUntrackedParameter<double>("hotDeadSigma",0.),
+		       iConfig.getUntrackedParameter<double>("hotDeadMinHits",25.),
+		       iConfig.getUntrackedParameter<bool>("excludeHotDead",false),
+		       iConfig.getUntrackedParameter<int>("hotDeadStatus",15));
+
+  // checkpoint of the sums, resumed by a restarted job
+  checkpoint_.configure(iConfig.getUntrackedParameter<std::string>("checkpoint",""),
+			iConfig.getUntrackedParameter<unsigned int>("checkpointLumis",20),
+			iConfig.getUntrackedParameter<double>("checkpointSeconds",0.));
+
+  // main sums of all the processes of the node in shared memory; a
+  // resumed job would add the events merged before it died again
+  std::string sharedSums = iConfig.getUntrackedParameter<std::string>("sharedSums","");
+  if (!sharedSums.empty() && checkpoint_.active())
+    edm::LogError("PhiSym") << "sharedSums can't be used with a checkpoint, "
+			    << "ET sums written by this process" << endl;
+  else if (!sharedSums.empty() &&
+	   shared_.attach(sharedSums, fixedPoint_,
+			  iConfig.getUntrackedParameter<unsigned int>("sharedSumsProcesses",0)))
+    edm::LogInfo("PhiSym") << "ET sums shared in " << sharedSums << endl;
+
+  // threshold sets, each PSet with label, eCut_barrel, ap and b
+  std::vector<edm::ParameterSet> sets =
+    iConfig.getUntrackedParameter<std::vector<edm::ParameterSet> >("thresholdSets",
+								   std::vector<edm::ParameterSet>());
+  thresholdSets_.resize(sets.size());
+  for (unsigned int iset=0; iset<sets.size(); iset++) {
+    thresholdSets_[iset].label     = sets[iset].getParameter<std::string>("label");
+    thresholdSets_[iset].eCut_barl = sets[iset].getParameter<double>("eCut_barrel");
+    thresholdSets_[iset].ap        = sets[iset].getParameter<double>("ap");
+    thresholdSets_[iset].b         = sets[iset].getParameter<double>("b");
+  }
+
+  // hit collections, each PSet with label, ecalRecHitsProducer,
+  // barrelHitCollection and endcapHitCollection
+  std::vector<edm::ParameterSet> colls =
+    iConfig.getUntrackedParameter<std::vector<edm::ParameterSet> >("hitCollections",
+								   std::vector<edm::ParameterSet>());
+  hitCollections_.resize(colls.size());
+  for (unsigned int icoll=0; icoll<colls.size(); icoll++) {
+    hitCollections_[icoll].label      = colls[icoll].getParameter<std::string>("label");
+    hitCollections_[icoll].producer   = colls[icoll].getParameter<std::string>("ecalRecHitsProducer");
+    hitCollections_[icoll].barrelHits = colls[icoll].getParameter<std::string>("barrelHitCollection");
+    hitCollections_[icoll].endcapHits = colls[icoll].getParameter<std::string>("endcapHitCollection");
+  }
+
+  for (int imiscal=0; imiscal<kNMiscalBinsEB; imiscal++) {
+    miscalEB_[imiscal]= (1-kMiscalRangeEB) + float(imiscal)* (2*kMiscalRangeEB/(kNMiscalBinsEB-1));
+  }
+  for (int imiscal=0; imiscal<kNMiscalBinsEE; imiscal++) {
+    miscalEE_[imiscal]= (1-kMiscalRangeEE) + float(imiscal)* (2*kMiscalRangeEE/(kNMiscalBinsEE-1));
+  }
+
+  if (energyHistos_ && (energyHistoBins_<=0 ||
+			energyHistoRangeEB_.size()!=2 || energyHistoRangeEE_.size()!=2)) {
+    edm::LogError("PhiSym") << "energyHistoBins must be positive and energyHistoRangeEB/EE "
+			    << "have two values, energy histograms not filled" << endl;
+    energyHistos_=false;
+  }
+
+  if (stopAtPrecision_ && !(targetPrecision_>0.)) {
+    edm::LogError("PhiSym") << "stopAtPrecision needs a positive targetPrecision" << endl;
+    stopAtPrecision_=false;
+  }
+  if (stopAtPrecision_) trackConvergence_=true;
+
+  if (hitCache_ && hitCacheWindow_.size()!=2) {
+    edm::LogError("PhiSym") << "hitCacheWindow needs two values, no hit cache written" << endl;
+    hitCache_=false;
+  }
+
+  // spectra are only filled with the k-factor scan, and not at all
+  // with an empty spectraFile
+  spectra_ = eventSet_==1 && !spectraFile_.empty();
+
+  // choose the hit loop for this job's modes
+  if (eventSet_==1) {
+    if (spectra_)
+      accumulateHits_ = reiteration_ ?
+	&EcalPhiSymStep1Algo::accumulateHits<true, true, true> :
+	&EcalPhiSymStep1Algo::accumulateHits<false,true, true>;
+    else
+      accumulateHits_ = reiteration_ ?
+	&EcalPhiSymStep1Algo::accumulateHits<true, true, false> :
+	&EcalPhiSymStep1Algo::accumulateHits<false,true, false>;
+  } else {
+    accumulateHits_ = reiteration_ ?
+      &EcalPhiSymStep1Algo::accumulateHits<true, false,false> :
+      &EcalPhiSymStep1Algo::accumulateHits<false,false,false>;
+  }
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::setUp(const edm::EventSetup& setup){
+
+  if (!helperSource_.update(setup, statusThreshold_, e_)) return;
+  bool refresh = isSetUp_;
+
+  edm::ESHandle<CaloGeometry> geoHandle;
+  setup.get<CaloGeometryRecord>().get(geoHandle);
+
+  for (unsigned int hi=0; hi<jobStatus_barl_.size(); hi++) {
+    EBDetId eb = EBDetId::unhashIndex(hi);
+    int sign = eb.zside()>0 ? 1 : 0;
+    jobStatus_barl_[hi] = std::max(int(jobStatus_barl_[hi]),
+				   std::min(255, e_.statusCode_barl[abs(eb.ieta())-1][eb.iphi()-1][sign]));
+  }
+  for (unsigned int hi=0; hi<jobStatus_endc_.size(); hi++) {
+    EEDetId ee = EEDetId::unhashIndex(hi);
+    int sign = ee.zside()>0 ? 1 : 0;
+    jobStatus_endc_[hi] = std::max(int(jobStatus_endc_[hi]),
+				   std::min(255, e_.statusCode_endc[ee.ix()-1][ee.iy()-1][sign]));
+  }
+
+  crystals_.setup(&(*geoHandle), e_, eCut_barl_, ap_, b_, allChannels_);
+  shared_.setRings(crystals_.ring_endc_);
+  for (unsigned int iset=0; iset<thresholdSets_.size(); iset++) {
+    ThresholdSet& set = thresholdSets_[iset];
+    set.crystals.setup(&(*geoHandle), e_, set.eCut_barl, set.ap, set.b, allChannels_);
+  }
+
+  // the cache window around the main cuts, all channels
+  if (hitCache_) {
+    cacheCrystals_.setup(&(*geoHandle), e_, eCut_barl_, ap_, b_, true);
+    for (unsigned int hi=0; hi<cacheCrystals_.eCut_barl_.size(); hi++) {
+      cacheCrystals_.eCut_barl_[hi]  *= hitCacheWindow_[0];
+      cacheCrystals_.etThr_barl_[hi] *= hitCacheWindow_[1];
+    }
+    for (unsigned int hi=0; hi<cacheCrystals_.eCut_endc_.size(); hi++) {
+      cacheCrystals_.eCut_endc_[hi]  *= hitCacheWindow_[0];
+      cacheCrystals_.etThr_endc_[hi] *= hitCacheWindow_[1];
+    }
+  }
+  isSetUp_=true;
+
+  // the previous constants are read once
+  if (refresh) return;
+  
+  if (reiteration_){   
+    
+    EcalCondHeader h;
+    // namespace fs = boost::filesystem;
+//     fs::path p(oldcalibfile_.c_str(),fs::native);
+//     if (!fs::exists(p)) edm::LogError("PhiSym") << "File not found: " 
+// 						<< oldcalibfile_ <<endl;
+    
+    edm::FileInPath fip("Calibration/EcalCalibAlgos/data/"+oldcalibfile_);
+    
+
+    
+    EcalIntercalibConstants oldCalibs;
+    int ret=
+    EcalIntercalibConstantsXMLTranslator::readXML(fip.fullPath(),h,oldCalibs);    
+    if (ret) edm::LogError("PhiSym")<<"Error reading XML files"<<endl;;
+    oldCalibs_.load(oldCalibs);
+    
+  } else {
+    // in fact if not reiterating, oldCalibs_ will never be used
+    edm::ESHandle<EcalIntercalibConstants> pIcal;      
+    setup.get<EcalIntercalibConstantsRcd>().get(pIcal);
+    oldCalibs_.load(*pIcal);
+
+  }
+  
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::setUp(const EcalPhiSymCrystalTable& crystals,
+				const EcalPhiSymConstants& oldCalibs){
+
+  crystals_ = crystals;
+  shared_.setRings(crystals_.ring_endc_);
+  for (unsigned int iset=0; iset<thresholdSets_.size(); iset++) {
+    ThresholdSet& set = thresholdSets_[iset];
+    set.crystals = crystals;
+    set.crystals.setCuts(set.eCut_barl, set.ap, set.b);
+  }
+  oldCalibs_ = oldCalibs;
+  isSetUp_=true;
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::book(EcalPhiSymStep1Sums& sums) const {
+
+  sums.sums_.setFixedPoint(fixedPoint_);
+  sums.lumiSums_.setFixedPoint(fixedPoint_);
+  sums.thresholdSums_.resize(thresholdSets_.size());
+  sums.collectionSums_.resize(hitCollections_.size());
+  for (unsigned int icoll=0; icoll<hitCollections_.size(); icoll++)
+    sums.collectionSums_[icoll].setFixedPoint(fixedPoint_);
+  sums.subsetSums_.resize(nSubsets_);
+  for (int isub=0; isub<nSubsets_; isub++)
+    sums.subsetSums_[isub].setFixedPoint(fixedPoint_);
+  for (unsigned int iset=0; iset<thresholdSets_.size(); iset++)
+    sums.thresholdSums_[iset].setFixedPoint(fixedPoint_);
+  if (spectra_) sums.spectra_.book();
+  if (energyHistos_) 
+    sums.energyHistos_.book(energyHistoBins_,
+			    energyHistoRangeEB_[0], energyHistoRangeEB_[1],
+			    energyHistoRangeEE_[0], energyHistoRangeEE_[1]);
+  sums.reset();
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::endJob(EcalPhiSymStep1Sums& sums)
+{
+
+  applyFlags(sums);
+
+  // start spectra stuff
+  if (sums.spectra_.booked()) sums.spectra_.write(spectraFile_);
+  
+
+
+
+  if (eventSet_==1) {
+    // calculate factors to convert from fractional deviation of ET sum from 
+    // the mean to the estimate of the miscalibration factor
+    getKfactors(sums);
+
+    std::ofstream k_barl_out("k_barl.dat", ios::out);
+    for (int ieta=0; ieta<kBarlRings; ieta++)
+      k_barl_out << ieta << " " << k_barl_[ieta][0] << " " << k_barl_[ieta][1] << endl;
+    k_barl_out.close();
+
+    std::ofstream k_endc_out("k_endc.dat", ios::out);
+    for (int ring=0; ring<kEndcEtaRings; ring++)
+      k_endc_out << ring << " " << k_endc_[ring][0] << " " << k_endc_[ring][1] << endl;
+    k_endc_out.close();
+  }
+
+
+  if (eventSet_!=0) {
+    // output ET sums
+
+    stringstream etsum_file_barl;
+    etsum_file_barl << "etsum_barl_"<<eventSet_<<".dat";
+
+    stringstream etsum_file_endc;
+    etsum_file_endc << "etsum_endc_"<<eventSet_<<".dat";
+
+    // with shared sums, those of the node by its last process
+    if (shared_.active() && !shared_.detach(sums.sums_)) {
+      std::cout << "ET sums added to the shared sums, written by the last process" << endl;
+    } else {
+      // endcap ring layout, not known if no event was seen
+      setupSums(sums.sums_);
+      sums.sums_.write(etsum_file_barl.str(), etsum_file_endc.str(), eventSet_);
+    }
+
+    for (unsigned int iset=0; iset<thresholdSets_.size(); iset++) {
+      const std::string& label = thresholdSets_[iset].label;
+      EcalPhiSymAccumulator& setSums = sums.thresholdSums_[iset];
+      setupSums(setSums);
+      setSums.write(label+"_"+etsum_file_barl.str(),
+		    label+"_"+etsum_file_endc.str(), eventSet_);
+    }
+
+    for (unsigned int icoll=0; icoll<hitCollections_.size(); icoll++) {
+      const std::string& label = hitCollections_[icoll].label;
+      EcalPhiSymAccumulator& collSums = sums.collectionSums_[icoll];
+      setupSums(collSums);
+      collSums.write(label+"_"+etsum_file_barl.str(),
+		     label+"_"+etsum_file_endc.str(), eventSet_);
+    }
+
+    for (int isub=0; isub<nSubsets_; isub++) {
+      stringstream prefix;
+      prefix << "sub" << isub << "_";
+      EcalPhiSymAccumulator& subSums = sums.subsetSums_[isub];
+      setupSums(subSums);
+      subSums.write(prefix.str()+etsum_file_barl.str(),
+		    prefix.str()+etsum_file_endc.str(), eventSet_);
+    }
+
+    if (sums.energyHistos_.booked()) {
+      stringstream ehisto_file;
+      ehisto_file << "ehisto_"<<eventSet_<<".dat";
+      sums.energyHistos_.write(ehisto_file.str(), eventSet_);
+    }
+
+    if (bins_.active()) {
+      stringstream bins_file;
+      bins_file << "bins_"<<eventSet_<<".dat";
+      std::ofstream bins_out(bins_file.str().c_str(), ios::out);
+
+      for (std::map<unsigned int, EcalPhiSymStep1Sums::Bin>::iterator it=sums.bins_.begin();
+	   it!=sums.bins_.end(); it++) {
+	std::string label = bins_.label(it->first);
+	bins_out << label << " " << it->second.nevents << endl;
+
+	setupSums(it->second.sums);
+	it->second.sums.write(label+"_"+etsum_file_barl.str(),
+			      label+"_"+etsum_file_endc.str(), eventSet_);
+      }
+      bins_out.close();
+
+      if (sums.unbinned_)
+	edm::LogError("PhiSym") << sums.unbinned_ << " events not binned, more than "
+				<< bins_.maxBins() << " bins" << endl;
+    }
+  }
+}
+
+
+void EcalPhiSymStep1Algo::setupSums(EcalPhiSymAccumulator& sums) const {
+
+  if (!isSetUp_) return;
+
+  sums.setup(e_);
+  for (unsigned int hi=0; hi<sums.status_barl_.size(); hi++)
+    sums.status_barl_[hi] = std::max(sums.status_barl_[hi], jobStatus_barl_[hi]);
+  for (unsigned int hi=0; hi<sums.status_endc_.size(); hi++)
+    sums.status_endc_[hi] = std::max(sums.status_endc_[hi], jobStatus_endc_[hi]);
+}
+
+
+//_____________________________________________________________________________
+// Events are split by a hash of their id rather than by their order,
+// so the subsets do not depend on the job splitting or on the streams.
+
+namespace {
+
+  // splitmix64 finalizer
+  unsigned long long mix(unsigned long long h){
+    h = (h ^ (h>>30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h>>27)) * 0x94d049bb133111ebULL;
+    return h ^ (h>>31);
+  }
+
+}
+
+int EcalPhiSymStep1Algo::subset(const edm::EventID& id) const {
+
+  if (nSubsets_<=0) return -1;
+
+  unsigned long long h = (static_cast<unsigned long long>(id.run())<<32) | id.luminosityBlock();
+  h = mix(mix(h) ^ id.event());
+  return h % nSubsets_;
+}
+
+
+//_____________________________________________________________________________
+
+EcalPhiSymStep1Sums::Bin* EcalPhiSymStep1Algo::bin(const edm::Event& event,
+						   EcalPhiSymStep1Sums& sums) const {
+
+  if (!bins_.active()) return 0;
+
+  unsigned int key = bins_.key(event);
+  std::map<unsigned int, EcalPhiSymStep1Sums::Bin>::iterator it = sums.bins_.find(key);
+  if (it!=sums.bins_.end()) return &it->second;
+
+  // a key is admitted or refused for the whole job, whichever stream
+  // sees it first, so no stream bins a key that another one dropped
+  {
+    std::lock_guard<std::mutex> guard(binMutex_);
+    if (!binKeys_.count(key)) {
+      if (binKeys_.size()>=bins_.maxBins()) {
+	sums.unbinned_++;
+	return 0;
+      }
+      binKeys_.insert(key);
+    }
+  }
+
+  EcalPhiSymStep1Sums::Bin& bin = sums.bins_[key];
+  bin.sums.setFixedPoint(fixedPoint_);
+  return &bin;
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::resume(EcalPhiSymStep1Sums& sums){
+
+  if (checkpoint_.resume(sums))
+    std::cout << "Resumed " << sums.nevents_ << " events from the checkpoint" << std::endl;
+
+  for (std::map<unsigned int, EcalPhiSymStep1Sums::Bin>::const_iterator it=sums.bins_.begin();
+       it!=sums.bins_.end(); it++)
+    binKeys_.insert(it->first);
+
+  // its hits are not those of the first lumi section
+  occupancy_.setBaseline(sums.sums_);
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::lumiProduct(EcalPhiSymStep1Sums& sums,
+				      EcalPhiSymLumiSums& product) const {
+
+  if (isSetUp_) sums.lumiSums_.setup(e_);
+  occupancy_.applyFlags(sums.lumiSums_);
+  sums.lumiSums_.fill(product);
+  product.nevents_ = sums.lumiEvents_;
+
+  sums.lumiSums_.reset();
+  sums.lumiEvents_ = 0;
+}
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::reportRun(const edm::Run& run, unsigned int npass,
+				    unsigned int nskipped, unsigned int nresumed){
+
+  std::cout  << "PHIREPRT : run "<< run.run() 
+             << " start " << (run.beginTime().value()>>32)
+             << " end "   << (run.endTime().value()>>32) 
+             << " dur "   << (run.endTime().value()>>32)- (run.beginTime().value()>>32)
+	  
+             << " npass "      << npass
+             << " nskipped "   << nskipped
+             << " nresumed "   << nresumed << std::endl;
+}
+
+
+bool EcalPhiSymStep1Algo::reportLumi(const edm::LuminosityBlock& lb, unsigned int npass){
+
+  if ((lb.endTime().value()>>32)- (lb.beginTime().value()>>32) <60 ) 
+    return false;
+
+  std::cout  << "PHILB : run "<< lb.run()
+             << " id " << lb.id() 
+             << " start " << (lb.beginTime().value()>>32)
+             << " end "   << (lb.endTime().value()>>32) 
+             << " dur "   << (lb.endTime().value()>>32)- (lb.beginTime().value()>>32)
+    
+             << " npass "      << npass  << std::endl;
+
+  return true;
+}
+
+
+void EcalPhiSymStep1Algo::reportConvergence(const edm::LuminosityBlock& lb,
+					    const EcalPhiSymAccumulator& sums) const {
+
+  if (!isSetUp_) return;
+
+  EcalPhiSymConvergence conv;
+  conv.compute(sums, crystals_);
+
+  int ringEB, signEB, ringEE, signEE;
+  double worstEB = conv.worstBarl(ringEB, signEB);
+  double worstEE = conv.worstEndc(ringEE, signEE);
+  bool converged = targetPrecision_>0. && conv.converged(targetPrecision_);
+
+  std::cout  << "PHICONV : run "<< lb.run()
+             << " id " << lb.id()
+             << " precEB " << worstEB << " ring " << ringEB << " sign " << signEB
+             << " precEE " << worstEE << " ring " << ringEE << " sign " << signEE
+             << " spreadEB " << conv.maxSpreadBarl()
+             << " spreadEE " << conv.maxSpreadEndc()
+             << " converged " << converged << std::endl;
+
+  if (converged && stopAtPrecision_ && !edm::shutdown_flag) {
+    edm::LogWarning("PhiSym") << "All rings at precision " << targetPrecision_
+			      << ", stopping" << std::endl;
+    edm::shutdown_flag = true;
+  }
+}
+
+
+void EcalPhiSymStep1Algo::checkOccupancy(const edm::LuminosityBlock& lb,
+					 const EcalPhiSymAccumulator& sums){
+
+  int nflagged = occupancy_.check(lb, sums, crystals_);
+  if (nflagged)
+    edm::LogWarning("PhiSym") << nflagged << " crystals flagged hot or dead in lumi section "
+			      << lb.id() << std::endl;
+}
+
+
+void EcalPhiSymStep1Algo::applyFlags(EcalPhiSymStep1Sums& sums) const {
+
+  if (!occupancy_.exclude()) return;
+
+  occupancy_.applyFlags(sums.sums_);
+  for (unsigned int iset=0; iset<sums.thresholdSums_.size(); iset++)
+    occupancy_.applyFlags(sums.thresholdSums_[iset]);
+  for (unsigned int icoll=0; icoll<sums.collectionSums_.size(); icoll++)
+    occupancy_.applyFlags(sums.collectionSums_[icoll]);
+  for (unsigned int isub=0; isub<sums.subsetSums_.size(); isub++)
+    occupancy_.applyFlags(sums.subsetSums_[isub]);
+  for (std::map<unsigned int, EcalPhiSymStep1Sums::Bin>::iterator it=sums.bins_.begin();
+       it!=sums.bins_.end(); it++)
+    occupancy_.applyFlags(it->second.sums);
+}
+
+
+//_____________________________________________________________________________
+
+namespace {
+
+  // add the hits selected in the batch to the barrel or endcap sums
+  int addBarl(const EcalPhiSymHitBatch& batch, EcalPhiSymAccumulator& acc){
+    if (acc.fixedPoint()) {
+      batch.accumulateMoments(&acc.esumKeV_barl_[0], &acc.et2sumKeV_barl_[0],
+			      &acc.e2sumKeV_barl_[0], acc.overflows_);
+      return batch.accumulate(&acc.etsumKeV_barl_[0], &acc.nhits_barl_[0], acc.overflows_);
+    }
+    batch.accumulateMoments(&acc.esum_barl_[0], &acc.et2sum_barl_[0], &acc.e2sum_barl_[0]);
+    return batch.accumulate(&acc.etsum_barl_[0], &acc.nhits_barl_[0]);
+  }
+
+  int addEndc(const EcalPhiSymHitBatch& batch, EcalPhiSymAccumulator& acc){
+    if (acc.fixedPoint()) {
+      batch.accumulateMoments(&acc.esumKeV_endc_[0], &acc.et2sumKeV_endc_[0],
+			      &acc.e2sumKeV_endc_[0], acc.overflows_);
+      return batch.accumulate(&acc.etsumKeV_endc_[0], &acc.nhits_endc_[0], acc.overflows_);
+    }
+    batch.accumulateMoments(&acc.esum_endc_[0], &acc.et2sum_endc_[0], &acc.e2sum_endc_[0]);
+    return batch.accumulate(&acc.etsum_endc_[0], &acc.nhits_endc_[0]);
+  }
+
+}
+
+
+//_____________________________________________________________________________
+// Select and accumulate the hits of one event. The job-wide modes are
+// template parameters, so that each combination is compiled without
+// the branches of the others; the constructor picks the one to run.
+
+template <bool Reiterate, bool KScan, bool Spectra>
+bool EcalPhiSymStep1Algo::accumulateHits(const EBRecHitCollection& barrelRecHits,
+					 const EERecHitCollection& endcapRecHits,
+					 EcalPhiSymStep1Sums& sums,
+					 int subset,
+					 EcalPhiSymAccumulator* binSums) const
+{
+
+  EcalPhiSymAccumulator& acc = sums.sums_;
+
+  bool pass=false;
+  // select interesting EcalRecHits (barrel), a batch of hits at a time
+  EcalPhiSymHitBatch batch;
+  EBRecHitCollection::const_iterator itb=barrelRecHits.begin();
+  while (itb!=barrelRecHits.end()) {
+
+    batch.clear();
+    for (; itb!=barrelRecHits.end() && !batch.full(); itb++) {
+      int hi = EBDetId(itb->id()).hashedIndex();
+      // if iterating, correct by the previous calib constants found,
+      // which are supplied in the form of correction 
+      batch.push(hi, itb->energy(), Reiterate ? oldCalibs_.barl_[hi] : 1.f);
+    }
+
+    batch.select(&crystals_.invCosh_barl_[0], &crystals_.eCut_barl_[0],
+		 &crystals_.etThr_barl_[0], &crystals_.sel_barl_[0]);
+
+    int selected = addBarl(batch, acc);
+    if (selected) pass=true;
+    sums.report_.hits_barl += batch.n;
+    sums.report_.selected_barl += selected;
+    if (subset>=0) addBarl(batch, sums.subsetSums_[subset]);
+    if (binSums)   addBarl(batch, *binSums);
+    if (sums.fillLumiSums_) addBarl(batch, sums.lumiSums_);
+
+    // other threshold sets, on the same calibrated energies
+    for (unsigned int iset=0; iset<thresholdSets_.size(); iset++) {
+      const EcalPhiSymCrystalTable& cuts = thresholdSets_[iset].crystals;
+      batch.recut(&cuts.eCut_barl_[0], &cuts.etThr_barl_[0], &cuts.sel_barl_[0]);
+      addBarl(batch, sums.thresholdSums_[iset]);
+    }
+
+    // uncalibrated ET, for other cuts and constants in step2
+    if (energyHistos_)
+      for (int i=0; i<batch.n; i++)
+	if (crystals_.sel_barl_[batch.hi[i]] && batch.scale[i]>0.f)
+	  sums.energyHistos_.fillBarl(batch.hi[i], batch.et[i]/batch.scale[i]);
+
+    if (!KScan) continue;
+
+    for (int i=0; i<batch.n; i++) {
+      int hi = batch.hi[i];
+      float e  = batch.e[i];
+      float et = batch.et[i];
+      int ieta = crystals_.ring_barl_[hi];
+      int sign = crystals_.sign_barl_[hi];
+
+      // apply a miscalibration to all crystals and increment the 
+      // ET sum, combined for all crystals
+      if (crystals_.good_barl_[hi]) {
+	if (acc.fixedPoint())
+	  fillMiscal(miscalEB_, kNMiscalBinsEB, e, et,
+		     crystals_.eCut_barl_[hi], crystals_.etThr_barl_[hi],
+		     EcalPhiSymAccumulator::toKeV(et), sums.etdiffKeV_barl_miscal_[ieta][sign]);
+	else
+	  fillMiscal(miscalEB_, kNMiscalBinsEB, e, et,
+		     crystals_.eCut_barl_[hi], crystals_.etThr_barl_[hi],
+		     double(et), sums.etdiff_barl_miscal_[ieta][sign]);
+      }
+
+      // spectra stuff
+      if (Spectra) sums.spectra_.fillBarl(ieta, sign, et, e);
+    }
+  }//for barl
+
+
+  // select interesting EcalRecHits (endcaps)
+  EERecHitCollection::const_iterator ite=endcapRecHits.begin();
+  while (ite!=endcapRecHits.end()) {
+
+    batch.clear();
+    for (; ite!=endcapRecHits.end() && !batch.full(); ite++) {
+      int hi = EEDetId(ite->id()).hashedIndex();
+      // if iterating, multiply by the previous correction factor
+      batch.push(hi, ite->energy(), Reiterate ? oldCalibs_.endc_[hi] : 1.f);
+    }
+
+    // e_cut = ap + eta_ring*b, precomputed per crystal
+    batch.select(&crystals_.invCosh_endc_[0], &crystals_.eCut_endc_[0],
+		 &crystals_.etThr_endc_[0], &crystals_.sel_endc_[0]);
+
+    int selected = addEndc(batch, acc);
+    if (selected) pass=true;
+    sums.report_.hits_endc += batch.n;
+    sums.report_.selected_endc += selected;
+    if (subset>=0) addEndc(batch, sums.subsetSums_[subset]);
+    if (binSums)   addEndc(batch, *binSums);
+    if (sums.fillLumiSums_) addEndc(batch, sums.lumiSums_);
+
+    for (unsigned int iset=0; iset<thresholdSets_.size(); iset++) {
+      const EcalPhiSymCrystalTable& cuts = thresholdSets_[iset].crystals;
+      batch.recut(&cuts.eCut_endc_[0], &cuts.etThr_endc_[0], &cuts.sel_endc_[0]);
+      addEndc(batch, sums.thresholdSums_[iset]);
+    }
+
+    if (energyHistos_)
+      for (int i=0; i<batch.n; i++)
+	if (crystals_.sel_endc_[batch.hi[i]] && batch.scale[i]>0.f)
+	  sums.energyHistos_.fillEndc(batch.hi[i], batch.et[i]/batch.scale[i]);
+
+    if (!KScan) continue;
+
+    for (int i=0; i<batch.n; i++) {
+      int hi = batch.hi[i];
+      float e  = batch.e[i];
+      float et = batch.et[i];
+      int ring = crystals_.ring_endc_[hi];
+      int sign = crystals_.sign_endc_[hi];
+
+      // apply a miscalibration to all crystals and increment the 
+      // ET sum, combined for all crystals
+      if (crystals_.good_endc_[hi]) {
+	if (acc.fixedPoint())
+	  fillMiscal(miscalEE_, kNMiscalBinsEE, e, et,
+		     crystals_.eCut_endc_[hi], crystals_.etThr_endc_[hi],
+		     EcalPhiSymAccumulator::toKeV(et), sums.etdiffKeV_endc_miscal_[ring][sign]);
+	else
+	  fillMiscal(miscalEE_, kNMiscalBinsEE, e, et,
+		     crystals_.eCut_endc_[hi], crystals_.etThr_endc_[hi],
+		     double(et), sums.etdiff_endc_miscal_[ring][sign]);
+      }
+
+      // spectra stuff
+      if (Spectra && ring!=-1) sums.spectra_.fillEndc(ring, sign, et, e);
+    }
+  }//for endc
+
+  return pass;
+}
+
+
+//_____________________________________________________________________________
+// The same selection on another collection, crystal table and previous
+// constants shared with the main one.
+
+bool EcalPhiSymStep1Algo::accumulateSums(const EBRecHitCollection& barrelRecHits,
+					 const EERecHitCollection& endcapRecHits,
+					 EcalPhiSymAccumulator& acc) const
+{
+
+  bool pass=false;
+  EcalPhiSymHitBatch batch;
+
+  EBRecHitCollection::const_iterator itb=barrelRecHits.begin();
+  while (itb!=barrelRecHits.end()) {
+    batch.clear();
+    for (; itb!=barrelRecHits.end() && !batch.full(); itb++) {
+      int hi = EBDetId(itb->id()).hashedIndex();
+      batch.push(hi, itb->energy(), reiteration_ ? oldCalibs_.barl_[hi] : 1.f);
+    }
+    batch.select(&crystals_.invCosh_barl_[0], &crystals_.eCut_barl_[0],
+		 &crystals_.etThr_barl_[0], &crystals_.sel_barl_[0]);
+    if (addBarl(batch, acc)) pass=true;
+  }
+
+  EERecHitCollection::const_iterator ite=endcapRecHits.begin();
+  while (ite!=endcapRecHits.end()) {
+    batch.clear();
+    for (; ite!=endcapRecHits.end() && !batch.full(); ite++) {
+      int hi = EEDetId(ite->id()).hashedIndex();
+      batch.push(hi, ite->energy(), reiteration_ ? oldCalibs_.endc_[hi] : 1.f);
+    }
+    batch.select(&crystals_.invCosh_endc_[0], &crystals_.eCut_endc_[0],
+		 &crystals_.etThr_endc_[0], &crystals_.sel_endc_[0]);
+    if (addEndc(batch, acc)) pass=true;
+  }
+
+  return pass;
+}
+
+
+//_____________________________________________________________________________
+// Hit cache: the same batch selection, on uncalibrated energies and the
+// loose window, so that replays can apply other cuts and constants.
+
+bool EcalPhiSymStep1Algo::openHitCache(EcalPhiSymHitCache& cache, int stream) const {
+
+  std::ostringstream fileName;
+  fileName << "hitcache_" << eventSet_;
+  if (stream>=0) fileName << "_" << stream;
+  fileName << ".bin";
+
+  return cache.open(fileName.str(), cacheCrystals_, e_,
+		    hitCacheWindow_[0], hitCacheWindow_[1]);
+}
+
+
+void EcalPhiSymStep1Algo::cacheHits(const EBRecHitCollection& barrelRecHits,
+				    const EERecHitCollection& endcapRecHits,
+				    const edm::EventID& id, EcalPhiSymHitCache& cache) const
+{
+
+  cache.clear();
+  EcalPhiSymHitBatch batch;
+
+  EBRecHitCollection::const_iterator itb=barrelRecHits.begin();
+  while (itb!=barrelRecHits.end()) {
+    batch.clear();
+    for (; itb!=barrelRecHits.end() && !batch.full(); itb++)
+      batch.push(EBDetId(itb->id()).hashedIndex(), itb->energy(), 1.f);
+    batch.select(&cacheCrystals_.invCosh_barl_[0], &cacheCrystals_.eCut_barl_[0],
+		 &cacheCrystals_.etThr_barl_[0], &cacheCrystals_.sel_barl_[0]);
+    for (int i=0; i<batch.n; i++)
+      if (batch.pass[i]) cache.addBarl(batch.hi[i], batch.e[i]);
+  }
+
+  EERecHitCollection::const_iterator ite=endcapRecHits.begin();
+  while (ite!=endcapRecHits.end()) {
+    batch.clear();
+    for (; ite!=endcapRecHits.end() && !batch.full(); ite++)
+      batch.push(EEDetId(ite->id()).hashedIndex(), ite->energy(), 1.f);
+    batch.select(&cacheCrystals_.invCosh_endc_[0], &cacheCrystals_.eCut_endc_[0],
+		 &cacheCrystals_.etThr_endc_[0], &cacheCrystals_.sel_endc_[0]);
+    for (int i=0; i<batch.n; i++)
+      if (batch.pass[i]) cache.addEndc(batch.hi[i], batch.e[i]);
+  }
+
+  cache.write(id);
+}
+
+
+//_____________________________________________________________________________
+// Find the range of miscalibration bins [first,last) in which the hit
+// passes m*e > eCut && m*et < et_thr, and record its ET there.
+// Both conditions are monotonic in m, so the range follows from the
+// linear bin estimate, settled on the exact per-bin comparisons.
+
+namespace {
+
+  int clampBin(double bin, int nbins){
+    if (!(bin > 0.)) return 0;
+    if (bin > nbins) return nbins;
+    return int(bin);
+  }
+
+}
+
+template <class T>
+void EcalPhiSymStep1Algo::fillMiscal(const double* miscal, int nbins,
+				     float e, float et, 
+				     float eCut, float et_thr,
+				     T q, T* etdiff)
+{
+
+  if (!(miscal[nbins-1]*e > eCut)) return;
+
+  if (e<=0. || et<=0.) {
+    // not monotonic, test each bin
+    for (int imiscal=0; imiscal<nbins; imiscal++) {
+      if (miscal[imiscal]*e > eCut && miscal[imiscal]*et < et_thr) {
+	etdiff[imiscal]   += q;
+	etdiff[imiscal+1] -= q;
+      }
+    }
+    return;
+  }
+
+  double step = miscal[1]-miscal[0];
+
+  int first = clampBin(ceil((eCut/e - miscal[0])/step), nbins);
+  while (first>0 && miscal[first-1]*e > eCut) first--;
+  while (first<nbins && !(miscal[first]*e > eCut)) first++;
+
+  int last = clampBin(ceil((et_thr/et - miscal[0])/step), nbins);
+  while (last>0 && !(miscal[last-1]*et < et_thr)) last--;
+  while (last<nbins && miscal[last]*et < et_thr) last++;
+
+  if (first<last) {
+    etdiff[first] += q;
+    etdiff[last]  -= q;
+  }
+}
+
+template void EcalPhiSymStep1Algo::fillMiscal<double>(const double*, int, float, float,
+						      float, float, double, double*);
+template void EcalPhiSymStep1Algo::fillMiscal<long long>(const double*, int, float, float,
+							 float, float, long long, long long*);
+
+
+//_____________________________________________________________________________
+
+void EcalPhiSymStep1Algo::getKfactors(const EcalPhiSymStep1Sums& sums)
+{
+
+  // ET sum for each miscalibration: running sum of the per-bin
+  // differences, scaled by the miscalibration
+  bool fixedPoint = sums.sums_.fixedPoint();
+  for(int sign=0; sign<kSides; sign++) {
+    for (int ieta=0; ieta<kBarlRings; ieta++) {
+      double etsum=0.;
+      long long etsumKeV=0;
+      for (int imiscal=0; imiscal<kNMiscalBinsEB; imiscal++) {
+	etsum    += sums.etdiff_barl_miscal_[ieta][sign][imiscal];
+	etsumKeV += sums.etdiffKeV_barl_miscal_[ieta][sign][imiscal];
+	etsum_barl_miscal_[imiscal][ieta][sign] =
+	  miscalEB_[imiscal]*(fixedPoint ? etsumKeV*1e-6 : etsum);
+      }
+    }
+    for (int ring=0; ring<kEndcEtaRings; ring++) {
+      double etsum=0.;
+      long long etsumKeV=0;
+      for (int imiscal=0; imiscal<kNMiscalBinsEE; imiscal++) {
+	etsum    += sums.etdiff_endc_miscal_[ring][sign][imiscal];
+	etsumKeV += sums.etdiffKeV_endc_miscal_[ring][sign][imiscal];
+	etsum_endc_miscal_[imiscal][ring][sign] =
+	  miscalEE_[imiscal]*(fixedPoint ? etsumKeV*1e-6 : etsum);
+      }
+    }
+  }
+
+  float epsilon_T_eb[kNMiscalBinsEB];
+  float epsilon_M_eb[kNMiscalBinsEB];
+
+  float epsilon_T_ee[kNMiscalBinsEE];
+  float epsilon_M_ee[kNMiscalBinsEE];
+
+  std::vector<TGraph*>  k_barl_graph(kBarlRings*kSides);
+  std::vector<TCanvas*> k_barl_plot(kBarlRings*kSides);
+
+  for(int sign=0; sign<kSides; sign++) {
+    for (int ieta=0; ieta<kBarlRings; ieta++) {
+      for (int imiscal=0; imiscal<kNMiscalBinsEB; imiscal++) {
+	int middlebin =  int (kNMiscalBinsEB/2);
+	epsilon_T_eb[imiscal] = etsum_barl_miscal_[imiscal][ieta][sign]/etsum_barl_miscal_[middlebin][ieta][sign] - 1.;
+	epsilon_M_eb[imiscal] = miscalEB_[imiscal] - 1.;
+	/*
+	//PRINT DEBUG
+	if( ieta==0 )
+	  cout << "DEBUG !!! "  << sign << "  " << ieta << "  " << imiscal << "  " 
+               << miscalEB_[imiscal] << "  " 
+	       << etsum_barl_miscal_[imiscal][ieta][sign] << "  " 
+	       << etsum_barl_miscal_[middlebin][ieta][sign] << "  "
+	       << epsilon_M_eb[imiscal] << "  " 
+	       << epsilon_T_eb[imiscal] << endl;
+	//END DEBUG
+	*/
+      }
+      int index_b = ieta+sign*kBarlRings;
+      k_barl_graph[index_b] = new TGraph (kNMiscalBinsEB,epsilon_M_eb,epsilon_T_eb);
+      k_barl_graph[index_b]->Fit("pol1");
+
+      ostringstream t;
+      t<< "k_barl_" << ieta+1 << "_" << sign; 
+      k_barl_plot[index_b] = new TCanvas(t.str().c_str(),"");
+      k_barl_plot[index_b]->SetFillColor(10);
+      k_barl_plot[index_b]->SetGrid();
+      k_barl_graph[index_b]->SetMarkerSize(1.);
+      k_barl_graph[index_b]->SetMarkerColor(4);
+      k_barl_graph[index_b]->SetMarkerStyle(20);
+      k_barl_graph[index_b]->GetXaxis()->SetLimits(-1.*kMiscalRangeEB,kMiscalRangeEB);
+      k_barl_graph[index_b]->GetXaxis()->SetTitleSize(.05);
+      k_barl_graph[index_b]->GetYaxis()->SetTitleSize(.05);
+      k_barl_graph[index_b]->GetXaxis()->SetTitle("#epsilon_{M}");
+      k_barl_graph[index_b]->GetYaxis()->SetTitle("#epsilon_{T}");
+      k_barl_graph[index_b]->Draw("AP");
+
+      k_barl_[ieta][sign] = k_barl_graph[index_b]->GetFunction("pol1")->GetParameter(1);
+      std::cout << "k_barl_[" << ieta << "][" << sign << "]=" << k_barl_[ieta][sign] << std::endl;
+    }//ieta
+  }//sign
+
+  std::vector<TGraph*>  k_endc_graph(kEndcEtaRings*kSides);
+  std::vector<TCanvas*> k_endc_plot(kEndcEtaRings*kSides);
+
+  for(int sign=0; sign<kSides; sign++) {
+    for (int ring=0; ring<kEndcEtaRings; ring++) {
+      for (int imiscal=0; imiscal<kNMiscalBinsEE; imiscal++) {
+	int middlebin =  int (kNMiscalBinsEE/2);
+	epsilon_T_ee[imiscal] = etsum_endc_miscal_[imiscal][ring][sign]/etsum_endc_miscal_[middlebin][ring][sign] - 1.;
+	epsilon_M_ee[imiscal] = miscalEE_[imiscal] - 1.;
+      }
+      int index_e = ring+sign*kEndcEtaRings;
+      k_endc_graph[index_e] = new TGraph (kNMiscalBinsEE,epsilon_M_ee,epsilon_T_ee);
+      k_endc_graph[index_e]->Fit("pol1");
+
+      ostringstream t;
+      t<< "k_endc_" << ring+1 << "_" << sign;
+      k_endc_plot[index_e] = new TCanvas(t.str().c_str(),"");
+      k_endc_plot[index_e]->SetFillColor(10);
+      k_endc_plot[index_e]->SetGrid();
+      k_endc_graph[index_e]->SetMarkerSize(1.);
+      k_endc_graph[index_e]->SetMarkerColor(4);
+      k_endc_graph[index_e]->SetMarkerStyle(20);
+      k_endc_graph[index_e]->GetXaxis()->SetLimits(-1*kMiscalRangeEE,kMiscalRangeEE);
+      k_endc_graph[index_e]->GetXaxis()->SetTitleSize(.05);
+      k_endc_graph[index_e]->GetYaxis()->SetTitleSize(.05);
+      k_endc_graph[index_e]->GetXaxis()->SetTitle("#epsilon_{M}");
+      k_endc_graph[index_e]->GetYaxis()->SetTitle("#epsilon_{T}");
+      k_endc_graph[index_e]->Draw("AP");
+
+      k_endc_[ring][sign] = k_endc_graph[index_e]->GetFunction("pol1")->GetParameter(1);
+      std::cout << "k_endc_[" << ring << "][" << sign << "]=" << k_endc_[ring][sign] << std::endl;
+    }//ieta
+  }//sign
+ 
+  TFile f("PhiSymmetryCalibration_kFactors.root","recreate");
+  for(int sign=0; sign<kSides; sign++) {
+    for (int ieta=0; ieta<kBarlRings; ieta++) { 
+      int index_b = ieta+sign*kBarlRings;
+      k_barl_plot[index_b]->Write();
+      delete k_barl_plot [index_b]; 
+      delete k_barl_graph[index_b];
+    }
+    for (int ring=0; ring<kEndcEtaRings; ring++) { 
+      int index_e = ring+sign*kEndcEtaRings;
+      k_endc_plot[index_e]->Write();
+      delete k_endc_plot [index_e];
+      delete k_endc_graph[index_e];
+    }
+  }
+  f.Close();
+
+}
@@ -0,0 +1,183 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymStep1Sums.h"
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymCheckpoint.h"
+
+#include <stdint.h>
+
+
+namespace {
+
+  void writeSums(std::ostream& out, const std::vector<EcalPhiSymAccumulator>& sums){
+    phisym::writePod(out, uint64_t(sums.size()));
+    for (unsigned int i=0; i<sums.size(); i++) sums[i].writeState(out);
+  }
+
+  bool readSums(std::istream& in, std::vector<EcalPhiSymAccumulator>& sums){
+    uint64_t n;
+    if (!phisym::readPod(in, n) || n!=sums.size()) return false;
+    for (unsigned int i=0; i<sums.size(); i++)
+      if (!sums[i].readState(in)) return false;
+    return true;
+  }
+
+}
+
+
+EcalPhiSymStep1Sums::EcalPhiSymStep1Sums() :
+  unbinned_(0), nevents_(0), fillLumiSums_(false), lumiEvents_(0) {
+
+  reset();
+}
+
+
+void EcalPhiSymStep1Sums::reset(){
+
+  sums_.reset();
+  for (unsigned int iset=0; iset<thresholdSums_.size(); iset++)
+    thresholdSums_[iset].reset();
+  for (unsigned int icoll=0; icoll<collectionSums_.size(); icoll++)
+    collectionSums_[icoll].reset();
+  for (unsigned int isub=0; isub<subsetSums_.size(); isub++)
+    subsetSums_[isub].reset();
+
+  bins_.clear();
+  unbinned_=0;
+
+  for(int sign=0; sign<kSides; sign++){
+    for (int ieta=0; ieta<kBarlRings; ieta++) 
+      for (int imiscal=0; imiscal<=kNMiscalBinsEB; imiscal++) {
+	etdiff_barl_miscal_[ieta][sign][imiscal]=0.;
+	etdiffKeV_barl_miscal_[ieta][sign][imiscal]=0;
+      }
+    for (int ring=0; ring<kEndcEtaRings; ring++) 
+      for (int imiscal=0; imiscal<=kNMiscalBinsEE; imiscal++) {
+	etdiff_endc_miscal_[ring][sign][imiscal]=0.;
+	etdiffKeV_endc_miscal_[ring][sign][imiscal]=0;
+      }
+  }//sign
+
+  spectra_.reset();
+  energyHistos_.reset();
+
+  nevents_=0;
+  report_ = phisym::ReportCounts();
+
+  lumiSums_.reset();
+  lumiEvents_=0;
+}
+
+
+void EcalPhiSymStep1Sums::add(const EcalPhiSymStep1Sums& other){
+
+  sums_.add(other.sums_);
+  for (unsigned int iset=0; iset<thresholdSums_.size(); iset++)
+    thresholdSums_[iset].add(other.thresholdSums_[iset]);
+  for (unsigned int icoll=0; icoll<collectionSums_.size(); icoll++)
+    collectionSums_[icoll].add(other.collectionSums_[icoll]);
+  for (unsigned int isub=0; isub<subsetSums_.size(); isub++)
+    subsetSums_[isub].add(other.subsetSums_[isub]);
+
+  for (std::map<unsigned int, Bin>::const_iterator it=other.bins_.begin();
+       it!=other.bins_.end(); it++) {
+    std::map<unsigned int, Bin>::iterator mine = bins_.find(it->first);
+    if (mine==bins_.end()) {
+      bins_.insert(*it);
+    } else {
+      mine->second.sums.add(it->second.sums);
+      mine->second.nevents += it->second.nevents;
+    }
+  }
+  unbinned_ += other.unbinned_;
+
+  for(int sign=0; sign<kSides; sign++){
+    for (int ieta=0; ieta<kBarlRings; ieta++) 
+      for (int imiscal=0; imiscal<=kNMiscalBinsEB; imiscal++) {
+	etdiff_barl_miscal_[ieta][sign][imiscal] += other.etdiff_barl_miscal_[ieta][sign][imiscal];
+	etdiffKeV_barl_miscal_[ieta][sign][imiscal] += other.etdiffKeV_barl_miscal_[ieta][sign][imiscal];
+      }
+    for (int ring=0; ring<kEndcEtaRings; ring++) 
+      for (int imiscal=0; imiscal<=kNMiscalBinsEE; imiscal++) {
+	etdiff_endc_miscal_[ring][sign][imiscal] += other.etdiff_endc_miscal_[ring][sign][imiscal];
+	etdiffKeV_endc_miscal_[ring][sign][imiscal] += other.etdiffKeV_endc_miscal_[ring][sign][imiscal];
+      }
+  }//sign
+
+  spectra_.add(other.spectra_);
+  energyHistos_.add(other.energyHistos_);
+
+  nevents_ += other.nevents_;
+
+  lumiSums_.add(other.lumiSums_);
+  lumiEvents_ += other.lumiEvents_;
+}
+
+
+void EcalPhiSymStep1Sums::writeState(std::ostream& out) const {
+
+  sums_.writeState(out);
+  writeSums(out, thresholdSums_);
+  writeSums(out, collectionSums_);
+  writeSums(out, subsetSums_);
+
+  phisym::writePod(out, uint64_t(bins_.size()));
+  for (std::map<unsigned int, Bin>::const_iterator it=bins_.begin(); it!=bins_.end(); it++) {
+    phisym::writePod(out, it->first);
+    phisym::writePod(out, it->second.nevents);
+    it->second.sums.writeState(out);
+  }
+  phisym::writePod(out, unbinned_);
+
+  phisym::writePod(out, etdiff_barl_miscal_);
+  phisym::writePod(out, etdiff_endc_miscal_);
+  phisym::writePod(out, etdiffKeV_barl_miscal_);
+  phisym::writePod(out, etdiffKeV_endc_miscal_);
+
+  spectra_.writeState(out);
+  energyHistos_.writeState(out);
+
+  phisym::writePod(out, nevents_);
+}
+
+
+bool EcalPhiSymStep1Sums::readState(std::istream& in){
+
+  if (!sums_.readState(in) || !readSums(in, thresholdSums_) ||
+      !readSums(in, collectionSums_) || !readSums(in, subsetSums_))
+    return false;
+
+  uint64_t nbins;
+  if (!phisym::readPod(in, nbins)) return false;
+  bins_.clear();
+  for (uint64_t ibin=0; ibin<nbins; ibin++) {
+    unsigned int key;
+    if (!phisym::readPod(in, key)) return false;
+    Bin& bin = bins_[key];
+    bin.sums.setFixedPoint(sums_.fixedPoint());
+    if (!phisym::readPod(in, bin.nevents) || !bin.sums.readState(in)) return false;
+  }
+
+  return
+    phisym::readPod(in, unbinned_) &&
+    phisym::readPod(in, etdiff_barl_miscal_) &&
+    phisym::readPod(in, etdiff_endc_miscal_) &&
+    phisym::readPod(in, etdiffKeV_barl_miscal_) &&
+    phisym::readPod(in, etdiffKeV_endc_miscal_) &&
+    spectra_.readState(in) &&
+    energyHistos_.readState(in) &&
+    phisym::readPod(in, nevents_);
+}
+
+
+size_t EcalPhiSymStep1Sums::memory() const {
+
+  size_t bytes = sizeof(*this) + sums_.memory() + lumiSums_.memory() +
+    spectra_.memory() + energyHistos_.memory();
+  for (unsigned int iset=0; iset<thresholdSums_.size(); iset++)
+    bytes += thresholdSums_[iset].memory();
+  for (unsigned int icoll=0; icoll<collectionSums_.size(); icoll++)
+    bytes += collectionSums_[icoll].memory();
+  for (unsigned int isub=0; isub<subsetSums_.size(); isub++)
+    bytes += subsetSums_[isub].memory();
+  for (std::map<unsigned int, Bin>::const_iterator it=bins_.begin(); it!=bins_.end(); it++)
+    bytes += it->second.sums.memory();
+  return bytes;
+}
@@ -0,0 +1,50 @@
+#include "PhiSym/EcalCalibAlgos/interface/EcalPhiSymTowerIndex.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+
+#include <cstdlib>
+
+
+const int EcalPhiSymTowerIndex::kBarlTowersEta;
+const int EcalPhiSymTowerIndex::kBarlTowersPhi;
+const int EcalPhiSymTowerIndex::kEndcTowersX;
+const int EcalPhiSymTowerIndex::kEndcTowersY;
+
+
+EcalPhiSymTowerIndex::EcalPhiSymTowerIndex() :
+  nBarlTowers_(2*kBarlTowersEta*kBarlTowersPhi),
+  tower_barl_(EBDetId::kSizeForDenseIndexing, -1),
+  tower_endc_(EEDetId::kSizeForDenseIndexing, -1)
+{
+
+  for (int hi=0; hi<EBDetId::kSizeForDenseIndexing; hi++) {
+    EBDetId eb = EBDetId::unhashIndex(hi);
+    int sign = eb.zside()>0 ? 1 : 0;
+    tower_barl_[hi] = (sign*kBarlTowersEta + (abs(eb.ieta())-1)/5)*kBarlTowersPhi
+      + (eb.iphi()-1)/5;
+  }
+
+  // endcap blocks numbered in the order they are found, after the
+  // barrel towers
+  std::vector<int> block(2*kEndcTowersX*kEndcTowersY, -1);
+  int ntowers = nBarlTowers_;
+  for (int hi=0; hi<EEDetId::kSizeForDenseIndexing; hi++) {
+    EEDetId ee = EEDetId::unhashIndex(hi);
+    int sign = ee.zside()>0 ? 1 : 0;
+    int& tower = block[(sign*kEndcTowersX + (ee.ix()-1)/5)*kEndcTowersY + (ee.iy()-1)/5];
+    if (tower<0) tower = ntowers++;
+    tower_endc_[hi] = tower;
+  }
+
+  // counts, then offsets, then cells in hashed index order
+  offsets_.assign(ntowers+1, 0);
+  for (unsigned int hi=0; hi<tower_barl_.size(); hi++) offsets_[tower_barl_[hi]+1]++;
+  for (unsigned int hi=0; hi<tower_endc_.size(); hi++) offsets_[tower_endc_[hi]+1]++;
+  for (int t=0; t<ntowers; t++) offsets_[t+1] += offsets_[t];
+
+  cells_.resize(offsets_[ntowers]);
+  std::vector<int> next(offsets_.begin(), offsets_.end()-1);
+  for (unsigned int hi=0; hi<tower_barl_.size(); hi++) cells_[next[tower_barl_[hi]]++] = hi;
+  for (unsigned int hi=0; hi<tower_endc_.size(); hi++) cells_[next[tower_endc_[hi]]++] = hi;
+}
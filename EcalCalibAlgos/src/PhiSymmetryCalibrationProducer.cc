@@ -0,0 +1,173 @@
+#include "PhiSym/EcalCalibAlgos/interface/PhiSymmetryCalibrationProducer.h"
+#include "PhiSym/EcalCalibDataFormats/interface/EcalPhiSymLumiSums.h"
+
+// Framework
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include <iostream>
+#include <memory>
+
+
+//_____________________________________________________________________________
+
+PhiSymmetryCalibrationProducer::PhiSymmetryCalibrationProducer(const edm::ParameterSet& iConfig) :
+
+  algo_(iConfig),
+  ecalHitsProducer_(iConfig.getParameter<std::string>("ecalRecHitsProducer")),
+  barrelHits_( iConfig.getParameter< std::string > ("barrelHitCollection")),
+  endcapHits_( iConfig.getParameter< std::string > ("endcapHitCollection")),
+  isfirstpass_(true),
+  eventsinrun_(0),
+  skippedinrun_(0),
+  eventsinlb_(0)
+{
+
+  produces<EcalPhiSymLumiSums, edm::InLumi>();
+
+  // a restarted job can't put again the products of the lumi sections
+  // of the checkpoint, the output file of the job that died is lost
+  if (algo_.checkpoint().active()) {
+    edm::LogError("PhiSym") << "checkpoint can't be used with lumi section products, "
+			    << "no checkpoint written" << std::endl;
+    algo_.checkpoint().configure("", 0, 0.);
+  }
+}
+
+
+void PhiSymmetryCalibrationProducer::beginJob(){
+
+  algo_.book(sums_);
+  sums_.fillLumiSums_=true;
+}
+
+
+void PhiSymmetryCalibrationProducer::endJob(){
+
+  edm::LogInfo("Calibration") << "[PhiSymmetryCalibrationProducer] At end of job";
+
+  algo_.endJob(sums_);
+  cache_.close();
+
+  std::cout << "Events processed " << sums_.nevents_ << std::endl;
+}
+
+
+//_____________________________________________________________________________
+// Called at each event, as PhiSymmetryCalibration::analyze
+
+void PhiSymmetryCalibrationProducer::produce(edm::Event& event, const edm::EventSetup& setup){
+
+  using namespace edm;
+
+  phisym::ReportTimer timer(sums_.report_);
+  sums_.report_.events++;
+
+  if (!algo_.certifiedLumi(event.id())) {
+    skippedinrun_++;
+    sums_.report_.skipped++;
+    return;
+  }
+
+  if (isfirstpass_) {
+    if (algo_.hitCache()) algo_.openHitCache(cache_);
+    isfirstpass_=false;
+  }
+
+  Handle<EBRecHitCollection> barrelRecHitsHandle;
+  Handle<EERecHitCollection> endcapRecHitsHandle;
+
+  event.getByLabel(ecalHitsProducer_,barrelHits_,barrelRecHitsHandle);
+  event.getByLabel(ecalHitsProducer_,endcapHits_,endcapRecHitsHandle);
+  if (!barrelRecHitsHandle.isValid() || !endcapRecHitsHandle.isValid()) {
+    LogError("") << "[PhiSymmetryCalibrationProducer] Error! Can't get product!" << std::endl;
+    return;
+  }
+
+  if (cache_.isOpen())
+    algo_.cacheHits(*barrelRecHitsHandle, *endcapRecHitsHandle, event.id(), cache_);
+
+  EcalPhiSymStep1Sums::Bin* bin = algo_.bin(event, sums_);
+
+  bool pass = algo_.accumulate(*barrelRecHitsHandle, *endcapRecHitsHandle, sums_,
+			       algo_.subset(event.id()), bin ? &bin->sums : 0);
+
+  if (pass) {
+    sums_.nevents_++;
+    sums_.lumiEvents_++;
+    sums_.report_.passed++;
+    if (bin) bin->nevents++;
+    eventsinrun_++;
+    eventsinlb_++;
+  }
+
+  // additional collections, into their own sums
+  const std::vector<EcalPhiSymStep1Algo::HitCollection>& colls = algo_.hitCollections();
+  for (unsigned int icoll=0; icoll<colls.size(); icoll++) {
+    event.getByLabel(colls[icoll].producer,colls[icoll].barrelHits,barrelRecHitsHandle);
+    event.getByLabel(colls[icoll].producer,colls[icoll].endcapHits,endcapRecHitsHandle);
+    if (!barrelRecHitsHandle.isValid() || !endcapRecHitsHandle.isValid()) {
+      LogError("") << "[PhiSymmetryCalibrationProducer] Error! Can't get product "
+		   << colls[icoll].producer << std::endl;
+      continue;
+    }
+    algo_.accumulateSums(*barrelRecHitsHandle, *endcapRecHitsHandle,
+			 sums_.collectionSums_[icoll]);
+  }
+}
+
+
+//_____________________________________________________________________________
+
+void PhiSymmetryCalibrationProducer::beginRun(const edm::Run&, const edm::EventSetup& setup){
+
+  algo_.setUp(setup);
+}
+
+
+void PhiSymmetryCalibrationProducer::endRun(const edm::Run& run, const edm::EventSetup&){
+
+  EcalPhiSymStep1Algo::reportRun(run, eventsinrun_, skippedinrun_);
+  eventsinrun_=0;
+  skippedinrun_=0;
+
+  algo_.report().writeRun(run, runReport_, sums_.memory());
+  runReport_ = phisym::ReportCounts();
+}
+
+
+//_____________________________________________________________________________
+// Every lumi section gets its product, empty if no event passed
+
+void PhiSymmetryCalibrationProducer::endLuminosityBlockProduce(edm::LuminosityBlock& lb,
+							       const edm::EventSetup&){
+
+  // flags of this lumi section go with its product
+  if (algo_.flagHotDead()) algo_.checkOccupancy(lb, sums_.sums_);
+  if (algo_.sharedSums()) algo_.mergeShared(sums_.sums_);
+
+  std::unique_ptr<EcalPhiSymLumiSums> product(new EcalPhiSymLumiSums);
+  algo_.lumiProduct(sums_, *product);
+  lb.put(std::move(product));
+
+  algo_.report().writeLumi(lb, sums_.report_, sums_.memory());
+  runReport_.add(sums_.report_);
+  sums_.report_ = phisym::ReportCounts();
+
+  // short lumi sections are not reported, their events are
+  // counted in the next one
+  if (EcalPhiSymStep1Algo::reportLumi(lb, eventsinlb_)) {
+    eventsinlb_=0;
+    if (algo_.trackConvergence()) algo_.reportConvergence(lb, sums_.sums_);
+  }
+}
+
+DEFINE_FWK_MODULE(PhiSymmetryCalibrationProducer);
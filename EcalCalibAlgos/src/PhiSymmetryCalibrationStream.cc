@@ -0,0 +1,296 @@
+#include "PhiSym/EcalCalibAlgos/interface/PhiSymmetryCalibrationStream.h"
+
+// Framework
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include <iostream>
+
+
+//_____________________________________________________________________________
+// Class constructor, called once per stream
+
+PhiSymmetryCalibrationStream::PhiSymmetryCalibrationStream(const edm::ParameterSet& iConfig,
+							   const phisym::Step1Global* global) :
+
+  ecalHitsProducer_(iConfig.getParameter<std::string>("ecalRecHitsProducer")),
+  barrelHits_( iConfig.getParameter< std::string > ("barrelHitCollection")),
+  endcapHits_( iConfig.getParameter< std::string > ("endcapHitCollection")),
+  streamId_(0),
+  sums_(new EcalPhiSymStep1Sums),
+  cacheOpened_(false),
+  eventsinrun_(0),
+  skippedinrun_(0),
+  resumedinrun_(0),
+  eventsinlb_(0)
+{
+
+  global->algo.book(*sums_);
+}
+
+
+std::unique_ptr<phisym::Step1Global>
+PhiSymmetryCalibrationStream::initializeGlobalCache(const edm::ParameterSet& iConfig){
+
+  std::unique_ptr<phisym::Step1Global> global(new phisym::Step1Global(iConfig));
+  global->algo.book(*global->resumed);
+  global->algo.resume(*global->resumed);
+  return global;
+}
+
+
+void PhiSymmetryCalibrationStream::beginStream(edm::StreamID id){
+
+  streamId_ = id.value();
+}
+
+
+void PhiSymmetryCalibrationStream::endStream(){
+
+  cache_.close();
+
+  std::lock_guard<std::mutex> guard(globalCache()->mutex);
+  globalCache()->streamSums[streamId_] = std::move(sums_);
+}
+
+
+//_____________________________________________________________________________
+// Add the stream sums; they are integers, so that the result depends
+// neither on the order they are added in nor on which stream got which
+// event
+
+void PhiSymmetryCalibrationStream::globalEndJob(phisym::Step1Global* global){
+
+  edm::LogInfo("Calibration") << "[PhiSymmetryCalibrationStream] At end of job";
+
+  EcalPhiSymStep1Sums sums;
+  global->algo.book(sums);
+  sums.add(*global->resumed);
+
+  std::map<unsigned int, std::unique_ptr<EcalPhiSymStep1Sums> >::const_iterator it;
+  for (it=global->streamSums.begin(); it!=global->streamSums.end(); ++it)
+    sums.add(*it->second);
+
+  global->algo.endJob(sums);
+
+  std::cout<<"Events processed " << sums.nevents_<< std::endl;
+}
+
+
+//_____________________________________________________________________________
+// Called at each event
+
+void PhiSymmetryCalibrationStream::analyze(const edm::Event& event, const edm::EventSetup& setup){
+
+  using namespace edm;
+
+  const phisym::Step1Global* global = globalCache();
+
+  phisym::ReportTimer timer(sums_->report_);
+  sums_->report_.events++;
+
+  if (!global->algo.certifiedLumi(event.id())) {
+    skippedinrun_++;
+    sums_->report_.skipped++;
+    return;
+  }
+  if (global->algo.resumedLumi(event.id())) {
+    resumedinrun_++;
+    sums_->report_.resumed++;
+    return;
+  }
+
+  Handle<EBRecHitCollection> barrelRecHitsHandle;
+  Handle<EERecHitCollection> endcapRecHitsHandle;
+  
+  event.getByLabel(ecalHitsProducer_,barrelHits_,barrelRecHitsHandle);
+  event.getByLabel(ecalHitsProducer_,endcapHits_,endcapRecHitsHandle);
+  if (!barrelRecHitsHandle.isValid() || !endcapRecHitsHandle.isValid()) {
+    LogError("") << "[PhiSymmetryCalibrationStream] Error! Can't get product!" << std::endl;
+    return;
+  }
+
+  if (global->algo.hitCache() && !cacheOpened_) {
+    global->algo.openHitCache(cache_, streamId_);
+    cacheOpened_=true;
+  }
+  if (cache_.isOpen())
+    global->algo.cacheHits(*barrelRecHitsHandle, *endcapRecHitsHandle, event.id(), cache_);
+
+  // bins are created per stream, for the keys admitted by the job
+  EcalPhiSymStep1Sums::Bin* bin = global->algo.bin(event, *sums_);
+
+  bool pass = global->algo.accumulate(*barrelRecHitsHandle, *endcapRecHitsHandle, *sums_,
+				      global->algo.subset(event.id()),
+				      bin ? &bin->sums : 0);
+
+  if (pass) {
+    sums_->nevents_++;
+    sums_->report_.passed++;
+    if (bin) bin->nevents++;
+    eventsinrun_++;
+    eventsinlb_++;
+  }
+
+  // additional collections, into their own sums
+  const std::vector<EcalPhiSymStep1Algo::HitCollection>& colls = global->algo.hitCollections();
+  for (unsigned int icoll=0; icoll<colls.size(); icoll++) {
+    event.getByLabel(colls[icoll].producer,colls[icoll].barrelHits,barrelRecHitsHandle);
+    event.getByLabel(colls[icoll].producer,colls[icoll].endcapHits,endcapRecHitsHandle);
+    if (!barrelRecHitsHandle.isValid() || !endcapRecHitsHandle.isValid()) {
+      LogError("") << "[PhiSymmetryCalibrationStream] Error! Can't get product "
+		   << colls[icoll].producer << std::endl;
+      continue;
+    }
+    global->algo.accumulateSums(*barrelRecHitsHandle, *endcapRecHitsHandle,
+				sums_->collectionSums_[icoll]);
+  }
+}
+
+
+//_____________________________________________________________________________
+// Run and lumi counters: each stream counts its own events, the framework
+// calls end*Summary one stream at a time
+
+void PhiSymmetryCalibrationStream::beginRun(const edm::Run&, const edm::EventSetup&){
+
+  eventsinrun_=0;
+  skippedinrun_=0;
+  resumedinrun_=0;
+}
+
+
+std::shared_ptr<phisym::Step1Count>
+PhiSymmetryCalibrationStream::globalBeginRunSummary(const edm::Run&, const edm::EventSetup& setup,
+						    const RunContext* ctx){
+
+  const phisym::Step1Global* global = ctx->global();
+  {
+    std::lock_guard<std::mutex> guard(global->mutex);
+    global->algo.setUp(setup);
+  }
+
+  return std::make_shared<phisym::Step1Count>();
+}
+
+
+void PhiSymmetryCalibrationStream::endRunSummary(const edm::Run&, const edm::EventSetup&,
+						 phisym::Step1Count* count) const {
+
+  count->npass += eventsinrun_;
+  count->nskipped += skippedinrun_;
+  count->nresumed += resumedinrun_;
+}
+
+
+void PhiSymmetryCalibrationStream::globalEndRunSummary(const edm::Run& run, const edm::EventSetup&,
+						       const RunContext* context, phisym::Step1Count* count){
+
+  EcalPhiSymStep1Algo::reportRun(run, count->npass, count->nskipped, count->nresumed);
+
+  const phisym::Step1Global* global = context->global();
+  std::lock_guard<std::mutex> guard(global->mutex);
+  global->algo.report().writeRun(run, global->runReport, global->memory);
+  global->runReport = phisym::ReportCounts();
+}
+
+
+void PhiSymmetryCalibrationStream::beginLuminosityBlock(const edm::LuminosityBlock&,
+							const edm::EventSetup&){
+
+  eventsinlb_=0;
+}
+
+
+std::shared_ptr<phisym::Step1Count>
+PhiSymmetryCalibrationStream::globalBeginLuminosityBlockSummary(const edm::LuminosityBlock&,
+								const edm::EventSetup&,
+								const LuminosityBlockContext* context){
+
+  std::shared_ptr<phisym::Step1Count> count = std::make_shared<phisym::Step1Count>();
+
+  // decided before the streams hand in their sums
+  const phisym::Step1Global* global = context->global();
+  std::lock_guard<std::mutex> guard(global->mutex);
+  count->checkpoint = global->algo.checkpoint().due(1);
+  return count;
+}
+
+
+void PhiSymmetryCalibrationStream::endLuminosityBlockSummary(const edm::LuminosityBlock&,
+							     const edm::EventSetup&,
+							     phisym::Step1Count* count) const {
+
+  count->npass += eventsinlb_;
+
+  count->report.add(sums_->report_);
+  count->memory += sums_->memory();
+  sums_->report_ = phisym::ReportCounts();
+
+  const EcalPhiSymStep1Algo& algo = globalCache()->algo;
+  if (algo.trackConvergence() || algo.flagHotDead() || algo.sharedSums()) {
+    if (!count->sums) {
+      count->sums.reset(new EcalPhiSymAccumulator);
+      count->sums->setFixedPoint(sums_->sums_.fixedPoint());
+    }
+    count->sums->add(sums_->sums_);
+  }
+
+  if (count->checkpoint) {
+    if (!count->state) {
+      count->state.reset(new EcalPhiSymStep1Sums);
+      algo.book(*count->state);
+    }
+    count->state->add(*sums_);
+  }
+}
+
+
+void PhiSymmetryCalibrationStream::globalEndLuminosityBlockSummary(const edm::LuminosityBlock& lb,
+								   const edm::EventSetup&,
+								   const LuminosityBlockContext* context,
+								   phisym::Step1Count* count){
+
+  // short lumi sections are not reported, their events are
+  // counted in the next one
+  const phisym::Step1Global* global = context->global();
+  std::lock_guard<std::mutex> guard(global->mutex);
+
+  unsigned int npass = global->lumiCarry + count->npass;
+  bool reported = EcalPhiSymStep1Algo::reportLumi(lb, npass);
+  global->lumiCarry = reported ? 0 : npass;
+
+  // the streams' sums start empty on a resumed job
+  if (count->sums) count->sums->add(global->resumed->sums_);
+
+  if (reported && count->sums && global->algo.trackConvergence())
+    global->algo.reportConvergence(lb, *count->sums);
+  if (count->sums && global->algo.flagHotDead())
+    global->algo.checkOccupancy(lb, *count->sums);
+  if (count->sums && global->algo.sharedSums())
+    global->algo.mergeShared(*count->sums);
+
+  global->algo.report().writeLumi(lb, count->report, count->memory);
+  global->runReport.add(count->report);
+  global->memory = count->memory;
+
+  EcalPhiSymCheckpoint& checkpoint = global->algo.checkpoint();
+  if (checkpoint.active()) {
+    checkpoint.complete(lb.run(), lb.luminosityBlock());
+    if (count->state) {
+      count->state->add(*global->resumed);
+      global->algo.applyFlags(*count->state);
+      checkpoint.write(*count->state);
+    }
+  }
+}
+
+DEFINE_FWK_MODULE(PhiSymmetryCalibrationStream);
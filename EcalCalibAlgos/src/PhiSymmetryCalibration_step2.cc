@@ -7,6 +7,8 @@
 #include "Geometry/Records/interface/CaloGeometryRecord.h"
 #include "Geometry/CaloGeometry/interface/CaloGeometry.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "PhiSym/EcalCalibDataFormats/interface/EcalPhiSymLumiSums.h"
 
 #include "TH2F.h"
 
@@ -28,7 +30,9 @@ using namespace std;
 PhiSymmetryCalibration_step2::~PhiSymmetryCalibration_step2(){}
 
 
-PhiSymmetryCalibration_step2::PhiSymmetryCalibration_step2(const edm::ParameterSet& iConfig){
+PhiSymmetryCalibration_step2::PhiSymmetryCalibration_step2(const edm::ParameterSet& iConfig) :
+  helperSource_(iConfig)
+{
 
   statusThreshold_ =
        iConfig.getUntrackedParameter<int>("statusThreshold",0);
@@ -41,16 +45,50 @@ PhiSymmetryCalibration_step2::PhiSymmetryCalibration_step2(const edm::ParameterS
     iConfig.getUntrackedParameter<std::string>("oldcalibfile",
 					       "EcalIntercalibConstants.xml");
   reiteration_ = iConfig.getUntrackedParameter<bool>("reiteration",false);
+  fixedPoint_ = iConfig.getUntrackedParameter<bool>("fixedPointSums",false);
+  thresholdSet_ = iConfig.getUntrackedParameter<std::string>("thresholdSet","");
+  nSubsets_ = iConfig.getUntrackedParameter<int>("nSubsets",0);
+  energyHistos_ = iConfig.getUntrackedParameter<bool>("energyHistos",false);
+  eCut_barl_ = iConfig.getUntrackedParameter<double>("eCut_barrel",0.550);
+  ap_ = iConfig.getUntrackedParameter<double>("ap",-0.150);
+  b_ = iConfig.getUntrackedParameter<double>("b",0.600);
+  histoIterations_ = iConfig.getUntrackedParameter<int>("histoIterations",10);
+  histoTolerance_ = iConfig.getUntrackedParameter<double>("histoTolerance",1e-4);
+  lumiSums_ = iConfig.getUntrackedParameter<edm::InputTag>("lumiSums",edm::InputTag());
+  et2Sums_ = true;
+  bins_ = iConfig.getUntrackedParameter<std::vector<std::string> >("bins",
+								  std::vector<std::string>());
   firstpass_=true;
 }
 
 void PhiSymmetryCalibration_step2::analyze( const edm::Event& ev, 
 					    const edm::EventSetup& se){
+}
 
-  if (firstpass_) {
-    setUp(se);
-    firstpass_=false;    
+
+void PhiSymmetryCalibration_step2::beginRun(const edm::Run&, const edm::EventSetup& se){
+
+  setUp(se);
+}
+
+
+// The sums of the selected lumi sections of step1 EDM files, as written
+// by PhiSymmetryCalibrationProducer; the lumi sections to calibrate are
+// chosen with the lumisToProcess of the source
+
+void PhiSymmetryCalibration_step2::endLuminosityBlock(const edm::LuminosityBlock& lb,
+						      const edm::EventSetup&){
+
+  if (lumiSums_.label().empty()) return;
+
+  edm::Handle<EcalPhiSymLumiSums> lumiSums;
+  lb.getByLabel(lumiSums_, lumiSums);
+  if (!lumiSums.isValid()) {
+    edm::LogError("PhiSym") << "No " << lumiSums_.encode() << " in run " << lb.run()
+			    << " lumi section " << lb.luminosityBlock() << endl;
+    return;
   }
+  sums_.add(*lumiSums);
 }
 
 
@@ -60,8 +98,7 @@ void PhiSymmetryCalibration_step2::analyze( const edm::Event& ev,
 
 void PhiSymmetryCalibration_step2::setUp(const edm::EventSetup& se){
 
-  edm::ESHandle<EcalChannelStatus> chStatus;
-  se.get<EcalChannelStatusRcd>().get(chStatus);
+  if (!helperSource_.update(se, statusThreshold_, e_)) return;
 
   edm::ESHandle<CaloGeometry> geoHandle;
   se.get<CaloGeometryRecord>().get(geoHandle);
@@ -69,7 +106,16 @@ void PhiSymmetryCalibration_step2::setUp(const edm::EventSetup& se){
   barrelCells = geoHandle->getValidDetIds(DetId::Ecal, EcalBarrel);
   endcapCells = geoHandle->getValidDetIds(DetId::Ecal, EcalEndcap);
 
-  e_.setup(&(*geoHandle), &(*chStatus), statusThreshold_);
+  // worst status code over the runs
+  sums_.setup(e_);
+  // the status codes written by step1, merged with the current ones
+  sums_.applyStatusThreshold(statusThreshold_);
+
+  if (energyHistos_) crystals_.setup(&(*geoHandle), e_, eCut_barl_, ap_, b_);
+
+  // the constants are read once
+  if (!firstpass_) return;
+  firstpass_=false;
 
   /// if a miscalibration was applied, load it, if not put it to 1                                                                                                                                                                                                                                                                                                                                                                                                  
   if (have_initial_miscalib_){
@@ -81,19 +127,14 @@ void PhiSymmetryCalibration_step2::setUp(const edm::EventSetup& se){
     if (!fs::exists(p)) edm::LogError("PhiSym") << "File not found: "
                                                 << initialmiscalibfile_ <<endl;
 
+    EcalIntercalibConstants miscalib;
     int ret=
-      EcalIntercalibConstantsXMLTranslator::readXML(initialmiscalibfile_,h,miscalib_);
+      EcalIntercalibConstantsXMLTranslator::readXML(initialmiscalibfile_,h,miscalib);
     if (ret) edm::LogError("PhiSym")<<"Error reading XML files"<<endl;;
+    miscalib_.load(miscalib);
   } else {
 
-    for (vector<DetId>::iterator it=barrelCells.begin(); it!=barrelCells.end(); ++it){
-      miscalib_[*it]=1;
-    }
-
-    for (vector<DetId>::iterator it=endcapCells.begin(); it!=endcapCells.end(); ++it){
-      miscalib_[*it]=1;
-
-    }
+    miscalib_.fill(1.);
   }
 
   // if we are reiterating, read constants from previous iter                                                                                                                                                                                                                                                                                                                                                                                                       
@@ -108,23 +149,17 @@ void PhiSymmetryCalibration_step2::setUp(const edm::EventSetup& se){
     if (!fs::exists(p)) edm::LogError("PhiSym") << "File not found: "
                                                 << oldcalibfile_ <<endl;
 
+    EcalIntercalibConstants oldCalibs;
     int ret=
       EcalIntercalibConstantsXMLTranslator::readXML(oldcalibfile_,h,
-                                                    oldCalibs_);
+                                                    oldCalibs);
 
     if (ret) edm::LogError("PhiSym")<<"Error reading XML files"<<endl;;
+    oldCalibs_.load(oldCalibs);
 
   } else {
 
-    for (vector<DetId>::iterator it=barrelCells.begin();
-         it!=barrelCells.end(); ++it)
-      oldCalibs_[*it]=1;
-
-
-    for (vector<DetId>::iterator it=endcapCells.begin();
-         it!=endcapCells.end(); ++it)
-      oldCalibs_[*it]=1;
-
+    oldCalibs_.fill(1.);
 
   } // else                                                                                                                                                                                                                                                                                                                                        
 
@@ -134,56 +169,41 @@ void PhiSymmetryCalibration_step2::setUp(const edm::EventSetup& se){
 void PhiSymmetryCalibration_step2::beginJob(){
   
 
-  for (int ieta=0; ieta<kBarlRings; ieta++) {
-    for (int iphi=0; iphi<kBarlWedges; iphi++) {
-      for (int sign=0; sign<kSides; sign++) {
-	etsum_barl_[ieta][iphi][sign]=0.;
-	nhits_barl_[ieta][iphi][sign]=0;
-	esum_barl_[ieta][iphi][sign]=0.;
-	  
-      }
-    }
-  }
-
-  for (int ix=0; ix<kEndcWedgesX; ix++) {
-    for (int iy=0; iy<kEndcWedgesY; iy++) {
-      for (int sign=0; sign<kSides; sign++) {
-	etsum_endc_[ix][iy][sign]=0.;
-	nhits_endc_[ix][iy][sign]=0;
-	esum_endc_[ix][iy][sign]=0.;
-
-      }
-    }
-  }
+  // merge the step1 files as integer keV, independent of their order
+  sums_.setFixedPoint(fixedPoint_);
+  sums_.reset();
+  etsum_endc_uncorr.assign(EEDetId::kSizeForDenseIndexing, 0.);
 
   readEtSums();
+  if (energyHistos_ && !histos_.read("ehisto.dat"))
+    edm::LogError("PhiSym") << "Problems reading ehisto.dat" << endl;
   setupResidHistos();
 }
 
 void PhiSymmetryCalibration_step2::endJob(){
 
   if (firstpass_) {
-    edm::LogError("PhiSym")<< "Must process at least one event-Exiting" <<endl;
+    edm::LogError("PhiSym")<< "Must process at least one run-Exiting" <<endl;
     return;
       
   }
 
   // Here the real calculation of constants happens
 
+  // the status codes of the lumi section products, merged after beginRun
+  if (!lumiSums_.label().empty()) sums_.applyStatusThreshold(statusThreshold_);
+
   // perform the area correction for endcap etsum
   // NOT  USED  ANYMORE
 
   
-  for (int ix=0; ix<kEndcWedgesX; ix++) {
-    for (int iy=0; iy<kEndcWedgesY; iy++) {
-
-      int ring = e_.endcapRing_[ix][iy];
-
-      if (ring!=-1) {
-	for (int sign=0; sign<kSides; sign++) {
-	  etsum_endc_uncorr[ix][iy][sign] = etsum_endc_[ix][iy][sign];
-	  etsum_endc_[ix][iy][sign]*=e_.meanCellArea_[ring]/e_.cellArea_[ix][iy];
-	}
+  for (int sign=0; sign<kSides; sign++) {
+    for (int ring=0; ring<kEndcEtaRings; ring++) {
+      for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	int hi = sums_.endcRingCells()[i];
+	EEDetId ee = EEDetId::unhashIndex(hi);
+	etsum_endc_uncorr[hi] = sums_.etsum_endc_[hi];
+	sums_.etsum_endc_[hi]*=e_.meanCellArea_[ring]/e_.cellArea_[ee.ix()-1][ee.iy()-1];
       }
     }
   }
@@ -211,8 +231,9 @@ void PhiSymmetryCalibration_step2::endJob(){
   for (int ieta=0; ieta<kBarlRings; ieta++) {
     for (int iphi=0; iphi<kBarlWedges; iphi++) {
       for (int sign=0; sign<kSides; sign++) {
-	if(e_.goodCell_barl[ieta][iphi][sign]){
-	  float etsum = etsum_barl_[ieta][iphi][sign];
+	int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	if(sums_.goodCell_barl_[hi]){
+	  float etsum = sums_.etsum_barl_[hi];
 	  float epsilon_T = (etsum/etsumMean_barl_[ieta][sign]) - 1.;
 	  rawconst_barl[ieta][iphi][sign]  = epsilon_T + 1.;
 	  epsilon_M_barl[ieta][iphi][sign] = epsilon_T/k_barl_[ieta][sign];
@@ -229,8 +250,8 @@ void PhiSymmetryCalibration_step2::endJob(){
     for (int iy=0; iy<kEndcWedgesY; iy++) {
       for (int sign=0; sign<kSides; sign++) {
 	int ring = e_.endcapRing_[ix][iy];
-	if (ring!=-1 && e_.goodCell_endc[ix][iy][sign]) {
-	  float etsum = etsum_endc_[ix][iy][sign];
+	if (sums_.goodEndc(ix,iy,sign)) {
+	  float etsum = sums_.etsum_endc_[sums_.endcIndex(ix,iy,sign)];
 	  float epsilon_T = (etsum/etsumMean_endc_[ring][sign]) - 1.;
 	  rawconst_endc[ix][iy][sign]  = epsilon_T + 1.;
 	  epsilon_M_endc[ix][iy][sign] = epsilon_T/k_endc_[ring][sign];	    
@@ -248,6 +269,8 @@ void PhiSymmetryCalibration_step2::endJob(){
 
 
 
+  newErrors_.fill(0.);
+
   TFile ehistof("ehistos.root","recreate");  
 
   TH1D ebhisto("eb","eb",100, 0.,2.);
@@ -258,21 +281,26 @@ void PhiSymmetryCalibration_step2::endJob(){
     int ieta = abs(eb.ieta())-1;
     int iphi = eb.iphi()-1;
     int sign = eb.zside()>0 ? 1 : 0;
+    int hi = eb.hashedIndex();
 
     /// this is the new constant, or better, the correction to be applied
     /// to the old constant (EB)
-    if(e_.goodCell_barl[ieta][iphi][sign]){
-      newCalibs_[eb] =  oldCalibs_[eb]/(1+epsilon_M_barl[ieta][iphi][sign]);
+    if(sums_.goodCell_barl_[hi]){
+      newCalibs_.barl_[hi] =  oldCalibs_.barl_[hi]/(1+epsilon_M_barl[ieta][iphi][sign]);
+
+      // the ET sum is a compound Poisson sum, sigma^2 = sum ET^2
+      double sigma_eps = sqrt(sums_.et2sum_barl_[hi])/etsumMean_barl_[ieta][sign]/k_barl_[ieta][sign];
+      newErrors_.barl_[hi] = newCalibs_.barl_[hi]*sigma_eps/(1+epsilon_M_barl[ieta][iphi][sign]);
 
-      ebhisto.Fill(newCalibs_[eb]);
+      ebhisto.Fill(newCalibs_.barl_[hi]);
       
       // residual miscalibraition  / expected precision
       int index_b = ieta+sign*kBarlRings;
-      miscal_resid_barl_histos[index_b]->Fill(miscalib_[eb]*newCalibs_[eb]);
-      correl_barl_histos[index_b]->Fill(miscalib_[eb],newCalibs_[eb]);	
+      miscal_resid_barl_histos[index_b]->Fill(miscalib_.barl_[hi]*newCalibs_.barl_[hi]);
+      correl_barl_histos[index_b]->Fill(miscalib_.barl_[hi],newCalibs_.barl_[hi]);	
     }
     else
-      newCalibs_[eb] = 1.0;
+      newCalibs_.barl_[hi] = 1.0;
       
   }// barrelit
 
@@ -284,22 +312,29 @@ void PhiSymmetryCalibration_step2::endJob(){
     int ix = ee.ix()-1;
     int iy = ee.iy()-1;
     int sign = ee.zside()>0 ? 1 : 0;
+    int hi = ee.hashedIndex();
             
       
     /// this is the new constant, or better, the correction to be applied
     /// to the old constant (EB)
-    if(e_.goodCell_endc[ix][iy][sign]){
-      newCalibs_[ee] = oldCalibs_[ee]/(1+epsilon_M_endc[ix][iy][sign]);
+    if(sums_.goodCell_endc_[hi]){
+      newCalibs_.endc_[hi] = oldCalibs_.endc_[hi]/(1+epsilon_M_endc[ix][iy][sign]);
+
+      // with the area correction applied to the ET sum
+      int ring = e_.endcapRing_[ix][iy];
+      double area = e_.meanCellArea_[ring]/e_.cellArea_[ix][iy];
+      double sigma_eps = sqrt(sums_.et2sum_endc_[hi])*area/etsumMean_endc_[ring][sign]/k_endc_[ring][sign];
+      newErrors_.endc_[hi] = newCalibs_.endc_[hi]*sigma_eps/(1+epsilon_M_endc[ix][iy][sign]);
 
-      eehisto.Fill(newCalibs_[ee]);
+      eehisto.Fill(newCalibs_.endc_[hi]);
 
       // residual miscalibraition  / expected precision
       int index_e = e_.endcapRing_[ix][iy]+sign*kEndcEtaRings;
-      miscal_resid_endc_histos[index_e]->Fill(miscalib_[ee]*newCalibs_[ee]);;
-      correl_endc_histos[index_e]->Fill(miscalib_[ee],newCalibs_[ee]);
+      miscal_resid_endc_histos[index_e]->Fill(miscalib_.endc_[hi]*newCalibs_.endc_[hi]);;
+      correl_endc_histos[index_e]->Fill(miscalib_.endc_[hi],newCalibs_.endc_[hi]);
     }
     else
-      newCalibs_[ee] = 1.0;
+      newCalibs_.endc_[hi] = 1.0;
 
 
   }//endcapit
@@ -313,8 +348,20 @@ void PhiSymmetryCalibration_step2::endJob(){
   header.tag_="unknown";
   header.date_="Mar 24 1973";
  
+  EcalIntercalibConstants newCalibs;
+  newCalibs_.store(newCalibs);
   EcalIntercalibConstantsXMLTranslator::writeXML(newcalibfile,header,
-						 newCalibs_ );  
+						 newCalibs );  
+
+  // errors have the same container as the constants
+  if (et2Sums_) {
+    EcalIntercalibConstants newErrors;
+    newErrors_.store(newErrors);
+    EcalIntercalibConstantsXMLTranslator::writeXML("EcalIntercalibErrors_new.xml",header,
+						   newErrors );
+  } else
+    edm::LogError("PhiSym") << "Step1 sums without the ET^2 column: "
+			    << "EcalIntercalibErrors_new.xml not written" << endl;
 
   eehisto.Write();
   ebhisto.Write();
@@ -332,8 +379,9 @@ void PhiSymmetryCalibration_step2::endJob(){
     for (int iphi=0; iphi<kBarlWedges; iphi++) {
       for (int sign=0; sign<kSides; sign++) {
 
+	int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
 	ebf<< ieta<< " " << iphi << " " <<sign <<" " 
-	   << etsum_barl_[ieta][iphi][sign]<<"  " << nhits_barl_[ieta][iphi][sign] << endl;
+	   << sums_.etsum_barl_[hi]<<"  " << sums_.nhits_barl_[hi] << endl;
 	  
       }
     }
@@ -342,17 +390,248 @@ void PhiSymmetryCalibration_step2::endJob(){
   for (int ix=0; ix<kEndcWedgesX; ix++) {
     for (int iy=0; iy<kEndcWedgesY; iy++) {
       for (int sign=0; sign<kSides; sign++) {
+	int hi = sums_.endcIndex(ix,iy,sign);
 	eef<<ix<<" " <<iy<<" " <<sign<<" "
-	   <<  etsum_endc_[ix][iy][sign] << "  "<<  nhits_endc_[ix][iy][sign] <<endl;
+	   <<  (hi<0 ? 0. : sums_.etsum_endc_[hi]) << "  "<<  sums_.nhitsEndc(ix,iy,sign) <<endl;
 	  
 	  
       }
     }
   }
+
+  if (nSubsets_>1) subsetPrecision();
+
+  if (energyHistos_ && histos_.booked()) iterateEnergyHistos();
   
 }
 
 
+//_____________________________________________________________________________
+// Constants from the step1 energy histograms, iterated in memory: at
+// each iteration the ET sums are rebuilt from the bin centres scaled by
+// the current constants and cut with this job's eCut_barrel, ap and b,
+// and the constants corrected as in endJob, with simple ring means.
+// Written to EcalIntercalibConstants_hist.xml.
+
+namespace {
+
+  double histoEtSum(const EcalPhiSymEnergyHistos& histos, int det,
+		    const unsigned int* counts, float calib,
+		    float invCosh, float eCut, float etThr){
+    double etsum=0.;
+    for (int b=0; b<histos.nbins(); b++) {
+      if (!counts[b]) continue;
+      double et = calib*histos.center(det,b);
+      if (et/invCosh > eCut && et < etThr) etsum += counts[b]*et;
+    }
+    return etsum;
+  }
+
+}
+
+void PhiSymmetryCalibration_step2::iterateEnergyHistos(){
+
+  EcalPhiSymConstants calibs = oldCalibs_;
+
+  std::vector<double> etsum_barl(EBDetId::kSizeForDenseIndexing, 0.);
+  std::vector<double> etsum_endc(EEDetId::kSizeForDenseIndexing, 0.);
+
+  for (int iter=0; iter<histoIterations_; iter++) {
+
+    double sum2=0.;
+    int ncells=0;
+
+    for (int sign=0; sign<kSides; sign++) {
+      for (int ieta=0; ieta<kBarlRings; ieta++) {
+	double mean=0.;
+	int ngood=0;
+	for (int iphi=0; iphi<kBarlWedges; iphi++) {
+	  int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	  if (!sums_.goodCell_barl_[hi]) continue;
+	  etsum_barl[hi] = histoEtSum(histos_, 0, histos_.barl(hi), calibs.barl_[hi],
+				      crystals_.invCosh_barl_[hi], crystals_.eCut_barl_[hi],
+				      crystals_.etThr_barl_[hi]);
+	  mean += etsum_barl[hi];
+	  ngood++;
+	}
+	if (!ngood || mean<=0.) continue;
+	mean /= ngood;
+
+	for (int iphi=0; iphi<kBarlWedges; iphi++) {
+	  int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	  if (!sums_.goodCell_barl_[hi]) continue;
+	  double epsilon_M = (etsum_barl[hi]/mean - 1.)/k_barl_[ieta][sign];
+	  calibs.barl_[hi] /= 1+epsilon_M;
+	  sum2 += epsilon_M*epsilon_M;
+	  ncells++;
+	}
+      }//ieta
+
+      for (int ring=0; ring<kEndcEtaRings; ring++) {
+	double mean=0.;
+	int ngood=0;
+	for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	  int hi = sums_.endcRingCells()[i];
+	  if (!sums_.goodCell_endc_[hi]) continue;
+	  EEDetId ee = EEDetId::unhashIndex(hi);
+	  etsum_endc[hi] = histoEtSum(histos_, 1, histos_.endc(hi), calibs.endc_[hi],
+				      crystals_.invCosh_endc_[hi], crystals_.eCut_endc_[hi],
+				      crystals_.etThr_endc_[hi])
+	    * e_.meanCellArea_[ring]/e_.cellArea_[ee.ix()-1][ee.iy()-1];
+	  mean += etsum_endc[hi];
+	  ngood++;
+	}
+	if (!ngood || mean<=0.) continue;
+	mean /= ngood;
+
+	for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	  int hi = sums_.endcRingCells()[i];
+	  if (!sums_.goodCell_endc_[hi]) continue;
+	  double epsilon_M = (etsum_endc[hi]/mean - 1.)/k_endc_[ring][sign];
+	  calibs.endc_[hi] /= 1+epsilon_M;
+	  sum2 += epsilon_M*epsilon_M;
+	  ncells++;
+	}
+      }//ring
+    }//sign
+
+    double rms = ncells ? sqrt(sum2/ncells) : 0.;
+    std::cout << "PHIHISTO : iteration " << iter << " rms epsilon_M " << rms << std::endl;
+    if (rms < histoTolerance_) break;
+  }
+
+  EcalCondHeader header;
+  header.method_="phi symmetry, energy histograms";
+  header.version_="0";
+  header.datasource_="testdata";
+  header.since_=1;
+  header.tag_="unknown";
+  header.date_="Mar 24 1973";
+
+  EcalIntercalibConstants histCalibs;
+  calibs.store(histCalibs);
+  EcalIntercalibConstantsXMLTranslator::writeXML("EcalIntercalibConstants_hist.xml",header,
+						 histCalibs );
+}
+
+
+//_____________________________________________________________________________
+// Statistical precision from the data: the miscalibration epsilon_M of
+// each crystal is derived from each event subset alone, with simple
+// ring means over the good crystals. The spread over the subsets,
+// averaged in quadrature over the ring and divided by sqrt(N), is the
+// expected precision of the constants from the full sample.
+
+void PhiSymmetryCalibration_step2::subsetPrecision(){
+
+  std::vector<double> sum_barl (EBDetId::kSizeForDenseIndexing, 0.);
+  std::vector<double> sum2_barl(EBDetId::kSizeForDenseIndexing, 0.);
+  std::vector<double> sum_endc (EEDetId::kSizeForDenseIndexing, 0.);
+  std::vector<double> sum2_endc(EEDetId::kSizeForDenseIndexing, 0.);
+
+  EcalPhiSymAccumulator sub;
+  sub.setFixedPoint(fixedPoint_);
+  sub.setup(e_);
+
+  for (int isub=0; isub<nSubsets_; isub++) {
+
+    ostringstream prefix;
+    prefix << "sub" << isub << "_";
+    sub.reset();
+    sub.read(prefix.str()+"etsum_barl.dat", prefix.str()+"etsum_endc.dat");
+
+    for (int sign=0; sign<kSides; sign++) {
+      for (int ieta=0; ieta<kBarlRings; ieta++) {
+	double mean=0.;
+	int ngood=0;
+	for (int iphi=0; iphi<kBarlWedges; iphi++) {
+	  int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	  if (!sums_.goodCell_barl_[hi]) continue;
+	  mean += sub.etsum_barl_[hi];
+	  ngood++;
+	}
+	if (!ngood || mean<=0.) continue;
+	mean /= ngood;
+
+	for (int iphi=0; iphi<kBarlWedges; iphi++) {
+	  int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	  if (!sums_.goodCell_barl_[hi]) continue;
+	  double epsilon_M = (sub.etsum_barl_[hi]/mean - 1.)/k_barl_[ieta][sign];
+	  sum_barl [hi] += epsilon_M;
+	  sum2_barl[hi] += epsilon_M*epsilon_M;
+	}
+      }//ieta
+
+      for (int ring=0; ring<kEndcEtaRings; ring++) {
+	// area corrected, as for the constants of the full sample
+	double mean=0.;
+	int ngood=0;
+	for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	  int hi = sums_.endcRingCells()[i];
+	  if (!sums_.goodCell_endc_[hi]) continue;
+	  EEDetId ee = EEDetId::unhashIndex(hi);
+	  sub.etsum_endc_[hi] *= e_.meanCellArea_[ring]/e_.cellArea_[ee.ix()-1][ee.iy()-1];
+	  mean += sub.etsum_endc_[hi];
+	  ngood++;
+	}
+	if (!ngood || mean<=0.) continue;
+	mean /= ngood;
+
+	for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	  int hi = sums_.endcRingCells()[i];
+	  if (!sums_.goodCell_endc_[hi]) continue;
+	  double epsilon_M = (sub.etsum_endc_[hi]/mean - 1.)/k_endc_[ring][sign];
+	  sum_endc [hi] += epsilon_M;
+	  sum2_endc[hi] += epsilon_M*epsilon_M;
+	}
+      }//ring
+    }//sign
+  }//isub
+
+  // per crystal variance over the subsets, averaged over the ring;
+  // columns: ring, then spread and precision for each side
+  double n = nSubsets_;
+
+  std::ofstream barl_out("subsetPrecision_barl.dat", ios::out);
+  for (int ieta=0; ieta<kBarlRings; ieta++) {
+    barl_out << ieta;
+    for (int sign=0; sign<kSides; sign++) {
+      double var=0.;
+      int ngood=0;
+      for (int iphi=0; iphi<kBarlWedges; iphi++) {
+	int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	if (!sums_.goodCell_barl_[hi]) continue;
+	var += (sum2_barl[hi] - sum_barl[hi]*sum_barl[hi]/n)/(n-1.);
+	ngood++;
+      }
+      double spread = ngood ? sqrt(std::max(var/ngood, 0.)) : 0.;
+      barl_out << " " << spread << " " << spread/sqrt(n);
+    }
+    barl_out << endl;
+  }
+  barl_out.close();
+
+  std::ofstream endc_out("subsetPrecision_endc.dat", ios::out);
+  for (int ring=0; ring<kEndcEtaRings; ring++) {
+    endc_out << ring;
+    for (int sign=0; sign<kSides; sign++) {
+      double var=0.;
+      int ngood=0;
+      for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	int hi = sums_.endcRingCells()[i];
+	if (!sums_.goodCell_endc_[hi]) continue;
+	var += (sum2_endc[hi] - sum_endc[hi]*sum_endc[hi]/n)/(n-1.);
+	ngood++;
+      }
+      double spread = ngood ? sqrt(std::max(var/ngood, 0.)) : 0.;
+      endc_out << " " << spread << " " << spread/sqrt(n);
+    }
+    endc_out << endl;
+  }
+  endc_out.close();
+}
+
+
 
 
 void  PhiSymmetryCalibration_step2::fillConstantsHistos(){
@@ -389,42 +668,41 @@ void  PhiSymmetryCalibration_step2::fillConstantsHistos(){
 
     for (int ieta=0; ieta<kBarlRings; ieta++) {
       for (int iphi=0; iphi<kBarlWedges; iphi++) {
-	if(e_.goodCell_barl[ieta][iphi][sign]){
+	int hi = EcalPhiSymAccumulator::barlIndex(ieta,iphi,sign);
+	if(sums_.goodCell_barl_[hi]){
 
-	  EBDetId eb(thesign*( ieta+1 ), iphi+1);
 	  //int mod20= (iphi+1)%20;
 	  //if (mod20==0 || mod20==1 ||mod20==2) continue;  // exclude SM boundaries
-	  barreletamap.Fill(ieta*thesign + thesign,newCalibs_[eb]);
+	  barreletamap.Fill(ieta*thesign + thesign,newCalibs_.barl_[hi]);
 	  barreletamapraw.Fill(ieta*thesign + thesign,rawconst_barl[ieta][iphi][sign]);
 	  
-	  barrelmapold.Fill(iphi+1,ieta*thesign + thesign, oldCalibs_[eb]);
-	  barrelmapnew.Fill(iphi+1,ieta*thesign + thesign, newCalibs_[eb]);
-	  barrelmapratio.Fill(iphi+1,ieta*thesign + thesign, newCalibs_[eb]/oldCalibs_[eb]);
+	  barrelmapold.Fill(iphi+1,ieta*thesign + thesign, oldCalibs_.barl_[hi]);
+	  barrelmapnew.Fill(iphi+1,ieta*thesign + thesign, newCalibs_.barl_[hi]);
+	  barrelmapratio.Fill(iphi+1,ieta*thesign + thesign, newCalibs_.barl_[hi]/oldCalibs_.barl_[hi]);
 	}//if
       }//iphi
     }//ieta
 
     for (int ix=0; ix<kEndcWedgesX; ix++) {
       for (int iy=0; iy<kEndcWedgesY; iy++) {
-	if (e_.goodCell_endc[ix][iy][sign]){
-	  if (! EEDetId::validDetId(ix+1, iy+1,thesign)) continue;
-	  EEDetId ee(ix+1, iy+1,thesign);
+	if (sums_.goodEndc(ix,iy,sign)){
+	  int hi = sums_.endcIndex(ix,iy,sign);
 
 	  rawconst_endc_h.Fill(rawconst_endc[ix][iy][sign]);
-	  const_endc_h.Fill(newCalibs_[ee]);
-	  oldconst_endc_h.Fill(oldCalibs_[ee]);
-	  newvsraw_endc_h.Fill(rawconst_endc[ix][iy][sign],newCalibs_[ee]);
+	  const_endc_h.Fill(newCalibs_.endc_[hi]);
+	  oldconst_endc_h.Fill(oldCalibs_.endc_[hi]);
+	  newvsraw_endc_h.Fill(rawconst_endc[ix][iy][sign],newCalibs_.endc_[hi]);
 
 	  if(sign==1){
-	    endcapmapold_plus.Fill(ix+1,iy+1,oldCalibs_[ee]);
-	    endcapmapnew_plus.Fill(ix+1,iy+1,newCalibs_[ee]);
-	    endcapmapratio_plus.Fill(ix+1,iy+1,newCalibs_[ee]/oldCalibs_[ee]);
+	    endcapmapold_plus.Fill(ix+1,iy+1,oldCalibs_.endc_[hi]);
+	    endcapmapnew_plus.Fill(ix+1,iy+1,newCalibs_.endc_[hi]);
+	    endcapmapratio_plus.Fill(ix+1,iy+1,newCalibs_.endc_[hi]/oldCalibs_.endc_[hi]);
 	    
 	  }
 	  else{
-	    endcapmapold_minus.Fill(ix+1,iy+1,oldCalibs_[ee]);
-	    endcapmapnew_minus.Fill(ix+1,iy+1,newCalibs_[ee]);
-	    endcapmapratio_minus.Fill(ix+1,iy+1,newCalibs_[ee]/oldCalibs_[ee]);
+	    endcapmapold_minus.Fill(ix+1,iy+1,oldCalibs_.endc_[hi]);
+	    endcapmapnew_minus.Fill(ix+1,iy+1,newCalibs_.endc_[hi]);
+	    endcapmapratio_minus.Fill(ix+1,iy+1,newCalibs_.endc_[hi]/oldCalibs_.endc_[hi]);
 	  }
 
 	}//if
@@ -551,13 +829,14 @@ void PhiSymmetryCalibration_step2::fillHistos()
     for (int ieta=0; ieta<kBarlRings; ieta++) {
 
       float TTNHsum_dummy=0;
+      int base = EcalPhiSymAccumulator::barlIndex(ieta,0,sign);
   
       for (int iphi=0; iphi<kBarlWedges; iphi++) 
 	{
-	  if(!e_.goodCell_barl[ieta][iphi][sign])
+	  if(!sums_.goodCell_barl_[base+iphi])
 	    NbadTT++;
       
-	  TTNHsum_dummy+=nhits_barl_[ieta][iphi][sign];
+	  TTNHsum_dummy+=sums_.nhits_barl_[base+iphi];
   
 	  if((iphi+1)%5==0)
 	    {
@@ -607,17 +886,18 @@ void PhiSymmetryCalibration_step2::fillHistos()
 
     //cout << "ieta =  "<< ieta << endl;
     for (int sign=0; sign<kSides; sign++) {
+      int base = EcalPhiSymAccumulator::barlIndex(ieta,0,sign);
       
       for (int iphi=0; iphi<kBarlWedges; iphi++) {
-	float etsum = etsum_barl_[ieta][iphi][sign];
+	float etsum = sums_.etsum_barl_[base+iphi];
 	if (etsum<low && etsum!=0.) low=etsum;
 	if (etsum>high) high=etsum;
 	
-	float esum = esum_barl_[ieta][iphi][sign];
+	float esum = sums_.esum_barl_[base+iphi];
 	if (esum<low_e && esum!=0.) low_e=esum;
 	if (esum>high_e) high_e=esum;
 	
-	int nhit= nhits_barl_[ieta][iphi][sign];
+	int nhit= sums_.nhits_barl_[base+iphi];
 	if (nhit<low_hit && nhit!=0.) low_hit=nhit;
 	if (nhit>high_hit) high_hit=nhit;
       }
@@ -655,9 +935,9 @@ void PhiSymmetryCalibration_step2::fillHistos()
       for (int iphi=0; iphi<kBarlWedges; iphi++) {
 		//cout << iphi <<endl; 
 	
-	if(e_.goodCell_barl[ieta][iphi][sign]){
-	  float etsum = etsum_barl_[ieta][iphi][sign];
-	  float esum  = esum_barl_[ieta][iphi][sign];
+	if(sums_.goodCell_barl_[base+iphi]){
+	  float etsum = sums_.etsum_barl_[base+iphi];
+	  float esum  = sums_.esum_barl_[base+iphi];
 	  etsumMean_barl1[ieta][sign]+=etsum;
 	  esumMean_barl1[ieta][sign]+=esum;
 	  ngc++;
@@ -704,8 +984,8 @@ void PhiSymmetryCalibration_step2::fillHistos()
 
       for (int iphi=0; iphi<kBarlWedges; iphi++) {
 	  //cout << "iphi =" << iphi << endl;
-	  float etsum = etsum_barl_[ieta][iphi][sign];
-	  float esum  = esum_barl_[ieta][iphi][sign];
+	  float etsum = sums_.etsum_barl_[base+iphi];
+	  float esum  = sums_.esum_barl_[base+iphi];
 	  //float etsumMean = etsumMean_barl1[ieta][sign];
 	  //float etsumStDev = StDevETRingEB1[ieta][sign];
 	  //float diff = abs(etsum-etsumMean)/etsumStDev;
@@ -719,36 +999,36 @@ void PhiSymmetryCalibration_step2::fillHistos()
 	  int thesign = sign==1 ? 1:-1;
 	  NHTT_map->Fill(iphi+1,ieta*thesign+ thesign, NHTTcry[ieta][iphi][sign]);  
  //cout << "sign = " << sign << "    thesign =" << thesign << endl;	
-	  //float HotCryFlag=(nhits_barl_[ieta][iphi][sign]/(nhitsMean/25.));
+	  //float HotCryFlag=(sums_.nhits_barl_[base+iphi]/(nhitsMean/25.));
 	  diffNH_histo_map->Fill(iphi+1,ieta*thesign+ thesign, diffNH);
 	  float cut = -3;
 	  if((iphi>4 && iphi<15) || (iphi>184 && iphi<195)) cut = -4;
 	  
-	  if(e_.goodCell_barl[ieta][iphi][sign] && diffNH > cut)// && HotCryFlag<8.)
+	  if(sums_.goodCell_barl_[base+iphi] && diffNH > cut)// && HotCryFlag<8.)
 	    {
 	//    cout << "isgood" << endl;  
 	      //etsumMean_barl_[ieta][sign]+=etsum;
 	      //esumMean_barl_[ieta][sign]+=esum;
-	      //NHitsMean_barl_[ieta][sign]+=nhits_barl_[ieta][iphi][sign];
+	      //NHitsMean_barl_[ieta][sign]+=sums_.nhits_barl_[base+iphi];
 	      etsum_barl_histos[index_b]->Fill(etsum);
 	      esum_barl_histos[index_b]->Fill(esum);
-	      NH_barl_histos[index_b]->Fill(nhits_barl_[ieta][iphi][sign]);
+	      NH_barl_histos[index_b]->Fill(sums_.nhits_barl_[base+iphi]);
 	      ngc2++;  
 	    } 
 	  else 
 	    { 
 	      //cout << " bad crystal " ;
-	      if(e_.goodCell_barl[ieta][iphi][sign])
+	      if(sums_.goodCell_barl_[base+iphi])
 		{
 		  //cout << " (new)  " ;
 		  //e_.nBads_barl[ieta][sign]++;
 		}
 	      //cout << ieta<<", "<<iphi<<", "<<sign<<endl;
-	      if(e_.goodCell_barl[ieta][iphi][sign])
+	      if(sums_.goodCell_barl_[base+iphi])
 		NHTTbad_histo_map->Fill(iphi+1,ieta*thesign+ thesign, 1);
 	      else
 		NHTTbad_histo_map->Fill(iphi+1,ieta*thesign+ thesign, -1);  
-	      e_.goodCell_barl[ieta][iphi][sign] = false;
+	      sums_.goodCell_barl_[base+iphi] = false;
 	     }
       }
     //cout <<" " << endl;
@@ -768,10 +1048,10 @@ void PhiSymmetryCalibration_step2::fillHistos()
     NHitsMean_barl_[ieta][sign]=0.;
       
       for (int iphi=0; iphi<kBarlWedges; iphi++) {
-	  float etsum = etsum_barl_[ieta][iphi][sign];
-	  float esum  = esum_barl_[ieta][iphi][sign];
+	  float etsum = sums_.etsum_barl_[base+iphi];
+	  float esum  = sums_.esum_barl_[base+iphi];
 	    int thesign = sign==1 ? 1:-1;
-	  if(e_.goodCell_barl[ieta][iphi][sign] && etsum
+	  if(sums_.goodCell_barl_[base+iphi] && etsum
 	  >EByq[0] && etsum <EByq[1])
 	    { 
 	      etsum_barl_histos_cut[index_b]->Fill(etsum);
@@ -779,7 +1059,7 @@ void PhiSymmetryCalibration_step2::fillHistos()
 	      Xtals_Removed_EB->Fill(iphi, ieta*thesign, 1);  
 	      etsumMean_barl_[ieta][sign]+=etsum;
 	      esumMean_barl_[ieta][sign]+=esum;
-	      NHitsMean_barl_[ieta][sign]+=nhits_barl_[ieta][iphi][sign];
+	      NHitsMean_barl_[ieta][sign]+=sums_.nhits_barl_[base+iphi];
 	    } 
 	  else 
 	    {   
@@ -855,24 +1135,19 @@ void PhiSymmetryCalibration_step2::fillHistos()
   
       for (int iy=0; iy<kEndcWedgesY; iy++) {
 
-	if( e_.goodCell_endc[ix][iy][1]) StatusEEplus_before.Fill(ix,iy,1);
+	if( sums_.goodEndc(ix,iy,1)) StatusEEplus_before.Fill(ix,iy,1);
 	else  StatusEEplus_before.Fill(ix,iy,0);
 
 
-	if( e_.goodCell_endc[ix][iy][0]) StatusEEminus_before.Fill(ix,iy,1);
+	if( sums_.goodEndc(ix,iy,0)) StatusEEminus_before.Fill(ix,iy,1);
 	else  StatusEEplus_before.Fill(ix,iy,0);
 
 
-	if(e_.endcapRing_[ix][iy]==-1)
-	  {
-	    e_.goodCell_endc[ix][iy][0] = false;
-	    e_.goodCell_endc[ix][iy][1] = false;
-	  }    
-  
-	if(!e_.goodCell_endc[ix][iy][sign]) // if the crystal is bad adds 1 to te number of BC in the TT
+	// positions outside the rings are never good cells in sums_
+	if(!sums_.goodEndc(ix,iy,sign)) // if the crystal is bad adds 1 to te number of BC in the TT
 	  NbadTT++;
 	else    // adds the number of hits to the dummy variable
-	  TTNHsum_dummy+=nhits_endc_[ix][iy][sign];
+	  TTNHsum_dummy+=sums_.nhitsEndc(ix,iy,sign);
 	
 	if((iy+1)%5==0) // every five xtals...
 	  {
@@ -945,20 +1220,20 @@ void PhiSymmetryCalibration_step2::fillHistos()
       float nplus=0;
       float nminus=0;
 
-      if( e_.goodCell_endc[ix][iy][1]) StatusEEplus_after.Fill(ix,iy,1);
+      if( sums_.goodEndc(ix,iy,1)) StatusEEplus_after.Fill(ix,iy,1);
       else  StatusEEplus_after.Fill(ix,iy,0);
 
 
-      if( e_.goodCell_endc[ix][iy][0]) StatusEEminus_after.Fill(ix,iy,1);
+      if( sums_.goodEndc(ix,iy,0)) StatusEEminus_after.Fill(ix,iy,1);
       else  StatusEEplus_after.Fill(ix,iy,0);
 
     
-      if(e_.goodCell_endc[ix][iy][1] && NBCTTcry_EE[ix][iy][1] < 25) // if all the xtal is bad skips
+      if(sums_.goodEndc(ix,iy,1) && NBCTTcry_EE[ix][iy][1] < 25) // if all the xtal is bad skips
 	{
 	  nplus = NHTTcry_EE[ix][iy][1]*25./(25.-NBCTTcry_EE[ix][iy][1]);
 	  NHEEplus_map.Fill(ix, iy, nplus);
 	}   
-      if(e_.goodCell_endc[ix][iy][0] && NBCTTcry_EE[ix][iy][0] < 25 ) // if all the xtal is bad skips
+      if(sums_.goodEndc(ix,iy,0) && NBCTTcry_EE[ix][iy][0] < 25 ) // if all the xtal is bad skips
 	{
 	  nminus = NHTTcry_EE[ix][iy][0]*25./(25.-NBCTTcry_EE[ix][iy][0]);
 	  NHEEminus_map.Fill(ix, iy, nminus);
@@ -988,9 +1263,9 @@ void PhiSymmetryCalibration_step2::fillHistos()
 
   for (int ix=0; ix<kEndcWedgesX; ix++) {
     for (int iy=0; iy<kEndcWedgesY; iy++) {
-      if(!e_.goodCell_endc[ix][iy][1])
+      if(!sums_.goodEndc(ix,iy,1))
 	EEplus_killed.Fill(ix, iy, -1);
-      if(!e_.goodCell_endc[ix][iy][0])
+      if(!sums_.goodEndc(ix,iy,0))
 	EEminus_killed.Fill(ix, iy, -1);
 
       if( NBCTTcry_EE[ix][iy][1] > 24 ||   NBCTTcry_EE[ix][iy][0] > 24) 
@@ -1015,25 +1290,25 @@ void PhiSymmetryCalibration_step2::fillHistos()
 	float relativediffvalue =(diffvalue-meanEE)/sigmaEE; 
 	NHEEsigma_map.Fill(ix,iy,relativediffvalue);
 	NHEEratio_map.Fill(ix,iy, nplus/nminus);
-	if(e_.goodCell_endc[ix][iy][0])
+	if(sums_.goodEndc(ix,iy,0))
 	  {
 	    EEminus_killed.Fill(ix, iy, 0);
 	     
 	    if(relativediffvalue>3)
 	      {
 		EEminus_killed.Fill(ix, iy, 1);
-		e_.goodCell_endc[ix][iy][0] = false;
+		sums_.goodCell_endc_[sums_.endcIndex(ix,iy,0)] = false;
 	      }
 	     
 	  }
-	if(e_.goodCell_endc[ix][iy][1])
+	if(sums_.goodEndc(ix,iy,1))
 	  {
 	    EEplus_killed.Fill(ix, iy, 0);
 	      
 	    if(relativediffvalue<-3)
 	      {
 		EEplus_killed.Fill(ix, iy, 1);
-		e_.goodCell_endc[ix][iy][1] = false;
+		sums_.goodCell_endc_[sums_.endcIndex(ix,iy,1)] = false;
 	      }
 	      
 	  }
@@ -1061,26 +1336,25 @@ void PhiSymmetryCalibration_step2::fillHistos()
 
     for (int sign=0; sign<kSides; sign++) {
 
-      for (int ix=0; ix<kEndcWedgesX; ix++) {
-	for (int iy=0; iy<kEndcWedgesY; iy++) {
-	  if (e_.endcapRing_[ix][iy]==ring) {
-	    float etsum = etsum_endc_[ix][iy][sign];
-	    if (etsum<low && etsum!=0.) low=etsum;
-	    if (etsum>high) high=etsum;
+      for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	int hi = sums_.endcRingCells()[i];
+	EEDetId ee = EEDetId::unhashIndex(hi);
 
-	    float etsum_uncorr = etsum_endc_uncorr[ix][iy][sign];
-	    if (etsum_uncorr<low_uncorr && etsum_uncorr!=0.) low_uncorr=etsum_uncorr;
-	    if (etsum_uncorr>high_uncorr) high_uncorr=etsum_uncorr;
+	float etsum = sums_.etsum_endc_[hi];
+	if (etsum<low && etsum!=0.) low=etsum;
+	if (etsum>high) high=etsum;
 
-	    float esum = esum_endc_[ix][iy][sign];
-	    if (esum<low_e && esum!=0.) low_e=esum;
-	    if (esum>high_e) high_e=esum;
+	float etsum_uncorr = etsum_endc_uncorr[hi];
+	if (etsum_uncorr<low_uncorr && etsum_uncorr!=0.) low_uncorr=etsum_uncorr;
+	if (etsum_uncorr>high_uncorr) high_uncorr=etsum_uncorr;
 
-	    float area = e_.cellArea_[ix][iy];
-	    if (area<low_a) low_a=area;
-	    if (area>high_a) high_a=area;
-	  }
-	}
+	float esum = sums_.esum_endc_[hi];
+	if (esum<low_e && esum!=0.) low_e=esum;
+	if (esum>high_e) high_e=esum;
+
+	float area = e_.cellArea_[ee.ix()-1][ee.iy()-1];
+	if (area<low_a) low_a=area;
+	if (area>high_a) high_a=area;
       }
     
       int index_e = ring+sign*kEndcEtaRings;
@@ -1114,19 +1388,15 @@ void PhiSymmetryCalibration_step2::fillHistos()
       etsumMean_endc_[ring][sign]=0.;
       esumMean_endc_[ring][sign]=0.;
       nBads_endc[ring][sign]=0;
-      for (int ix=0; ix<kEndcWedgesX; ix++) {
-	for (int iy=0; iy<kEndcWedgesY; iy++) {
-	  if (e_.endcapRing_[ix][iy]==ring) {
-	    if(e_.goodCell_endc[ix][iy][sign]){
-	      float etsum = etsum_endc_[ix][iy][sign];
-	      float esum  = esum_endc_[ix][iy][sign];
-	      float etsum_uncorr = etsum_endc_uncorr[ix][iy][sign];
-	      etsum_endc_histos[index_e]->Fill(etsum);
-	      etsum_endc_uncorr_histos[index_e]->Fill(etsum_uncorr);
-	      esum_endc_histos[index_e]->Fill(esum);
-     
-	    }
-	  }
+      for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	int hi = sums_.endcRingCells()[i];
+	if(sums_.goodCell_endc_[hi]){
+	  float etsum = sums_.etsum_endc_[hi];
+	  float esum  = sums_.esum_endc_[hi];
+	  float etsum_uncorr = etsum_endc_uncorr[hi];
+	  etsum_endc_histos[index_e]->Fill(etsum);
+	  etsum_endc_uncorr_histos[index_e]->Fill(etsum_uncorr);
+	  esum_endc_histos[index_e]->Fill(esum);
 	}
       }
       /*
@@ -1144,28 +1414,28 @@ void PhiSymmetryCalibration_step2::fillHistos()
       double lowerCut = meanEE-2*rmsEE;
       if(sign ==0) thesign=-1;	    
       
-      for (int ix=0; ix<kEndcWedgesX; ix++) {
-	for (int iy=0; iy<kEndcWedgesY; iy++) {
-	  if (e_.endcapRing_[ix][iy]==ring) {
-	    float etsum = etsum_endc_[ix][iy][sign];
-	    float esum  = esum_endc_[ix][iy][sign];
-	    //float etsum_uncorr = etsum_endc_uncorr[ix][iy][sign];
+      for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	int hi = sums_.endcRingCells()[i];
+	EEDetId ee = EEDetId::unhashIndex(hi);
+	int ix = ee.ix()-1;
+	int iy = ee.iy()-1;
+
+	float etsum = sums_.etsum_endc_[hi];
+	float esum  = sums_.esum_endc_[hi];
 	    
-	    if(e_.goodCell_endc[ix][iy][sign] && etsum >lowerCut && etsum <upperCut){
-	      Xtals_Removed_EE->Fill(ix*thesign, iy, 1); 
-	      etsumMean_endc_[ring][sign]+=etsum;
-	      esumMean_endc_[ring][sign]+=esum;
-	      etsum_endc_histos_cut[index_e]->Fill(etsum);
+	if(sums_.goodCell_endc_[hi] && etsum >lowerCut && etsum <upperCut){
+	  Xtals_Removed_EE->Fill(ix*thesign, iy, 1); 
+	  etsumMean_endc_[ring][sign]+=etsum;
+	  esumMean_endc_[ring][sign]+=esum;
+	  etsum_endc_histos_cut[index_e]->Fill(etsum);
 	    
-	      float area = e_.cellArea_[ix][iy];
-	      etsumvsarea_endc_histos[index_e]->Fill(area,etsum);
-	      esumvsarea_endc_histos[index_e]->Fill(area,esum);
-	    }
-	    else {
-	      nBads_endc[ring][sign]++;
-	      Xtals_Removed_EE->Fill(ix*thesign, iy, 2);
-	    }
-	  }
+	  float area = e_.cellArea_[ix][iy];
+	  etsumvsarea_endc_histos[index_e]->Fill(area,etsum);
+	  esumvsarea_endc_histos[index_e]->Fill(area,esum);
+	}
+	else {
+	  nBads_endc[ring][sign]++;
+	  Xtals_Removed_EE->Fill(ix*thesign, iy, 2);
 	}
       }
       
@@ -1219,31 +1489,34 @@ NHEEsigma.Write();
     int thesign = sign==1 ? 1:-1;
 
     for (int ieta=0; ieta<kBarlRings; ieta++) {
+      int base = EcalPhiSymAccumulator::barlIndex(ieta,0,sign);
       for (int iphi=0; iphi<kBarlWedges; iphi++) {
-	if(e_.goodCell_barl[ieta][iphi][sign]){
-	  barrelmap.Fill(iphi+1,ieta*thesign + thesign, etsum_barl_[ieta][iphi][sign]/etsumMean_barl_[0][sign]);
-	  barrelmap_e.Fill(iphi+1,ieta*thesign + thesign, esum_barl_[ieta][iphi][sign]/esumMean_barl_[0][sign]); //VS
-	  if (!nhits_barl_[ieta][iphi][sign]) nhits_barl_[ieta][iphi][sign] =1;
-	  barrelmap_divided.Fill( iphi+1,ieta*thesign + thesign, etsum_barl_[ieta][iphi][sign]/nhits_barl_[ieta][iphi][sign]);
-	  barrelmap_e_divided.Fill( iphi+1,ieta*thesign + thesign, esum_barl_[ieta][iphi][sign]/nhits_barl_[ieta][iphi][sign]); //VS
+	if(sums_.goodCell_barl_[base+iphi]){
+	  barrelmap.Fill(iphi+1,ieta*thesign + thesign, sums_.etsum_barl_[base+iphi]/etsumMean_barl_[0][sign]);
+	  barrelmap_e.Fill(iphi+1,ieta*thesign + thesign, sums_.esum_barl_[base+iphi]/esumMean_barl_[0][sign]); //VS
+	  if (!sums_.nhits_barl_[base+iphi]) sums_.nhits_barl_[base+iphi] =1;
+	  barrelmap_divided.Fill( iphi+1,ieta*thesign + thesign, sums_.etsum_barl_[base+iphi]/sums_.nhits_barl_[base+iphi]);
+	  barrelmap_e_divided.Fill( iphi+1,ieta*thesign + thesign, sums_.esum_barl_[base+iphi]/sums_.nhits_barl_[base+iphi]); //VS
 	  //int mod20= (iphi+1)%20;
 	  //if (mod20==0 || mod20==1 ||mod20==2) continue;  // exclude SM boundaries
-	  barreletamap.Fill(ieta*thesign + thesign,etsum_barl_[ieta][iphi][sign]/etsumMean_barl_[0][sign]);
+	  barreletamap.Fill(ieta*thesign + thesign,sums_.etsum_barl_[base+iphi]/etsumMean_barl_[0][sign]);
 	}//if
       }//iphi
     }//ieta
 
     for (int ix=0; ix<kEndcWedgesX; ix++) {
       for (int iy=0; iy<kEndcWedgesY; iy++) {
+	int hi = sums_.endcIndex(ix,iy,sign);
+	if (hi<0) continue;
 	if (sign==1) {
-	  endcmap_plus_corr.Fill(ix+1,iy+1,etsum_endc_[ix][iy][sign]/etsumMean_endc_[38][sign]);
-	  endcmap_plus_uncorr.Fill(ix+1,iy+1,etsum_endc_uncorr[ix][iy][sign]/etsumMean_endc_[38][sign]);
-	  endcmap_e_plus.Fill(ix+1,iy+1,esum_endc_[ix][iy][sign]/esumMean_endc_[38][sign]);
+	  endcmap_plus_corr.Fill(ix+1,iy+1,sums_.etsum_endc_[hi]/etsumMean_endc_[38][sign]);
+	  endcmap_plus_uncorr.Fill(ix+1,iy+1,etsum_endc_uncorr[hi]/etsumMean_endc_[38][sign]);
+	  endcmap_e_plus.Fill(ix+1,iy+1,sums_.esum_endc_[hi]/esumMean_endc_[38][sign]);
 	}
 	else{ 
-	  endcmap_minus_corr.Fill(ix+1,iy+1,etsum_endc_[ix][iy][sign]/etsumMean_endc_[38][sign]);
-	  endcmap_minus_uncorr.Fill(ix+1,iy+1,etsum_endc_uncorr[ix][iy][sign]/etsumMean_endc_[38][sign]);
-	  endcmap_e_minus.Fill(ix+1,iy+1,esum_endc_[ix][iy][sign]/esumMean_endc_[38][sign]);
+	  endcmap_minus_corr.Fill(ix+1,iy+1,sums_.etsum_endc_[hi]/etsumMean_endc_[38][sign]);
+	  endcmap_minus_uncorr.Fill(ix+1,iy+1,etsum_endc_uncorr[hi]/etsumMean_endc_[38][sign]);
+	  endcmap_e_minus.Fill(ix+1,iy+1,sums_.esum_endc_[hi]/esumMean_endc_[38][sign]);
 	}
       }//iy
     }//ix
@@ -1314,37 +1587,39 @@ NHEEsigma.Write();
 
     }//ring
 
-    for (int ix=0; ix<kEndcWedgesX; ix++) {
-      for (int iy=0; iy<kEndcWedgesY; iy++) {
+    for (int ring=0; ring<kEndcEtaRings; ring++) {
 
-	int ring = e_.endcapRing_[ix][iy];
-	int index_e = ring+sign*kEndcEtaRings;
+      int index_e = ring+sign*kEndcEtaRings;
 
-	if (ring!=-1) {
-	  int iphi_endc=-1;
-	  for (int ip=0; ip<e_.nRing_[ring]; ip++) {
-	    if (e_.cellPhi_[ix][iy]==e_.phi_endc_[ip][ring]) iphi_endc=ip;
-	  }
+      for (int i=sums_.endcRingBegin(ring,sign); i<sums_.endcRingEnd(ring,sign); i++) {
+	int hi = sums_.endcRingCells()[i];
+	EEDetId ee = EEDetId::unhashIndex(hi);
+	int ix = ee.ix()-1;
+	int iy = ee.iy()-1;
 
-	  if(iphi_endc!=-1){
-	    if(e_.goodCell_endc[ix][iy][sign]){
-	      if (sign==1){
-		etsumvsphi_endcp_corr[index_e]->Fill(iphi_endc,etsum_endc_[ix][iy][sign]);
-		etsumvsphi_endcp_uncorr[index_e]->Fill(iphi_endc,etsum_endc_uncorr[ix][iy][sign]);
-		esumvsphi_endcp[index_e]->Fill(iphi_endc,esum_endc_[ix][iy][sign]);
-	      } else {
-		etsumvsphi_endcm_corr[index_e]->Fill(iphi_endc,etsum_endc_[ix][iy][sign]);
-		etsumvsphi_endcm_uncorr[index_e]->Fill(iphi_endc,etsum_endc_uncorr[ix][iy][sign]);
-		esumvsphi_endcm[index_e]->Fill(iphi_endc,esum_endc_[ix][iy][sign]);
-	      }
-	    }//if
-	    etavsphi_endc[index_e]->Fill(iphi_endc,e_.cellPos_[ix][iy].eta());
-	    areavsphi_endc[index_e]->Fill(iphi_endc,e_.cellArea_[ix][iy]);
-	  } //if iphi_endc
+	int iphi_endc=-1;
+	for (int ip=0; ip<e_.nRing_[ring]; ip++) {
+	  if (e_.cellPhi_[ix][iy]==e_.phi_endc_[ip][ring]) iphi_endc=ip;
+	}
+
+	if(iphi_endc!=-1){
+	  if(sums_.goodCell_endc_[hi]){
+	    if (sign==1){
+	      etsumvsphi_endcp_corr[index_e]->Fill(iphi_endc,sums_.etsum_endc_[hi]);
+	      etsumvsphi_endcp_uncorr[index_e]->Fill(iphi_endc,etsum_endc_uncorr[hi]);
+	      esumvsphi_endcp[index_e]->Fill(iphi_endc,sums_.esum_endc_[hi]);
+	    } else {
+	      etsumvsphi_endcm_corr[index_e]->Fill(iphi_endc,sums_.etsum_endc_[hi]);
+	      etsumvsphi_endcm_uncorr[index_e]->Fill(iphi_endc,etsum_endc_uncorr[hi]);
+	      esumvsphi_endcm[index_e]->Fill(iphi_endc,sums_.esum_endc_[hi]);
+	    }
+	  }//if
+	  etavsphi_endc[index_e]->Fill(iphi_endc,e_.cellPos_[ix][iy].eta());
+	  areavsphi_endc[index_e]->Fill(iphi_endc,e_.cellArea_[ix][iy]);
+	} //if iphi_endc
 	  
-	}//if ring
-      }//iy
-    } //ix
+      }//ring cells
+    } //ring
 
     for(int ring =0; ring<kEndcEtaRings;++ring){
 
@@ -1378,22 +1653,20 @@ void PhiSymmetryCalibration_step2::readEtSums(){
 
   //read in ET sums
   
-  int ieta,iphi,sign,ix,iy,dummy;
-  double etsum;
-  unsigned int nhits;
-  std::ifstream etsum_barl_in("etsum_barl.dat", ios::in);
-  while ( etsum_barl_in >> dummy >> ieta >> iphi >> sign >> etsum >> nhits ) {
-    etsum_barl_[ieta][iphi][sign]+=etsum;
-    nhits_barl_[ieta][iphi][sign]+=nhits;
-
-  }
-
-  std::ifstream etsum_endc_in("etsum_endc.dat", ios::in);
-  while ( etsum_endc_in >> dummy >> ix >> iy >> sign >> etsum >> nhits>>dummy ) {
-    etsum_endc_[ix][iy][sign]+=etsum;
-    nhits_endc_[ix][iy][sign]+=nhits;
+  if (!lumiSums_.label().empty()) {
+    // summed lumi section by lumi section, E sums not available
+  } else if (!bins_.empty()) {
+    // sum of the selected step1 event bins
+    for (unsigned int ibin=0; ibin<bins_.size(); ibin++)
+      if (!sums_.read(bins_[ibin]+"_etsum_barl.dat", bins_[ibin]+"_etsum_endc.dat"))
+	et2Sums_=false;
+  } else {
+    // sums of one of the step1 threshold sets, if requested
+    std::string prefix = thresholdSet_.empty() ? "" : thresholdSet_+"_";
+    et2Sums_ = sums_.read(prefix+"etsum_barl.dat", prefix+"etsum_endc.dat");
   }
 
+  int dummy;
   std::ifstream k_barl_in("k_barl.dat", ios::in);
   for (int ieta=0; ieta<kBarlRings; ieta++) {
     k_barl_in >> dummy >> k_barl_[ieta][0] >> k_barl_[ieta][1];
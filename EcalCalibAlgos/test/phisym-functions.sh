@@ -150,13 +150,34 @@ dostep2(){
    cat $crabdir/$results/etsum_barl_*.dat > $crabdir/$results/etsum_barl.dat
    cat $crabdir/$results/etsum_endc_*.dat > $crabdir/$results/etsum_endc.dat
 
+   # prefixed sums of the step1 threshold sets and hit collections
+   # (thresholdSet in phisym_step2.py), event subsets (nSubsets) and
+   # event bins (bins), merged into <label>_etsum_barl.dat etc.
+   for label in `ls $crabdir/$results/*_etsum_barl_*.dat 2>/dev/null | xargs -n1 basename | sed 's/_etsum_barl_.*//' | sort -u` ; do
+     cat $crabdir/$results/${label}_etsum_barl_*.dat > $crabdir/$results/${label}_etsum_barl.dat
+     cat $crabdir/$results/${label}_etsum_endc_*.dat > $crabdir/$results/${label}_etsum_endc.dat
+     ln -sf $crabdir/$results/${label}_etsum_barl.dat
+     ln -sf $crabdir/$results/${label}_etsum_endc.dat
+   done
+
    ln -sf $crabdir/$results/k_barl.dat
    ln -sf $crabdir/$results/k_endc.dat
    ln -sf $crabdir/$results/etsum_barl.dat
    ln -sf $crabdir/$results/etsum_endc.dat
 
+   # per-crystal energy histograms (energyHistos)
+   if ls $crabdir/$results/ehisto_*.dat >/dev/null 2>&1 ; then
+     cat $crabdir/$results/ehisto_*.dat > $crabdir/$results/ehisto.dat
+     ln -sf $crabdir/$results/ehisto.dat
+   fi
+
    mkdir -p $i
 
+   # full-detector spectra from the per-job files
+   if ls $crabdir/$results/Espectra_*.root >/dev/null 2>&1 ; then
+     hadd -f $i/Espectra.root $crabdir/$results/Espectra_*.root >& /dev/null
+   fi
+
    cmsRun phisym_step2.py >& $i/cmsrun.step2.$i.log
 
    if [ $? -ne 0 ] ; then
@@ -167,15 +188,24 @@ dostep2(){
    rm k_endc.dat
    rm etsum_barl.dat
    rm etsum_endc.dat
+   rm -f *_etsum_barl.dat *_etsum_endc.dat
+   rm -f ehisto.dat
 
        
    mv $step2out $i
+   if ls subsetPrecision_*.dat >/dev/null 2>&1 ; then
+     mv subsetPrecision_*.dat $i
+   fi
+   if [ -f EcalIntercalibConstants_hist.xml ] ; then
+     mv EcalIntercalibConstants_hist.xml $i
+   fi
 
    if [ -f  $datadir/EcalIntercalibConstants.xml ] ; then
       mv $datadir/EcalIntercalibConstants.xml $datadir/EcalIntercalibConstants_$i.xml 
    fi
 
    cp EcalIntercalibConstants_new.xml $i/EcalIntercalibConstants_$i.xml
+   mv EcalIntercalibErrors_new.xml $i/EcalIntercalibErrors_$i.xml
    mv EcalIntercalibConstants_new.xml $datadir/EcalIntercalibConstants.xml
  
 }
@@ -224,6 +254,7 @@ dostep2loop(){
    fi
 
    cp EcalIntercalibConstants_new.xml $i/EcalIntercalibConstants_$i.xml
+   mv EcalIntercalibErrors_new.xml $i/EcalIntercalibErrors_$i.xml
    mv EcalIntercalibConstants_new.xml $datadir/EcalIntercalibConstants.xml
  
 }
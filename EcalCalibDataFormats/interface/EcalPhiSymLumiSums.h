@@ -0,0 +1,60 @@
+#ifndef _PhiSym_EcalCalibDataFormats_EcalPhiSymLumiSums_h_
+#define _PhiSym_EcalCalibDataFormats_EcalPhiSymLumiSums_h_
+
+//
+// Per-crystal phi-symmetry sums of one lumi section, put in the
+// LuminosityBlock by PhiSymmetryCalibrationProducer and read by
+// PhiSymmetryCalibration_step2. Dense arrays indexed by
+// EBDetId::hashedIndex() and EEDetId::hashedIndex(), ET and ET^2 sums
+// as float.
+//
+// mergeProduct() adds the sums, so that a lumi section split over
+// several files is merged by the framework when the files are.
+//
+
+#include <algorithm>
+#include <vector>
+
+class EcalPhiSymLumiSums {
+
+ public:
+
+  EcalPhiSymLumiSums() : nevents_(0) {}
+
+  bool mergeProduct(const EcalPhiSymLumiSums& other) {
+    if (other.etsum_barl_.size()!=etsum_barl_.size() ||
+	other.etsum_endc_.size()!=etsum_endc_.size())
+      return false;
+    for (unsigned int i=0; i<etsum_barl_.size(); i++) {
+      etsum_barl_[i] += other.etsum_barl_[i];
+      nhits_barl_[i] += other.nhits_barl_[i];
+      status_barl_[i] = std::max(status_barl_[i], other.status_barl_[i]);
+      et2sum_barl_[i] += other.et2sum_barl_[i];
+    }
+    for (unsigned int i=0; i<etsum_endc_.size(); i++) {
+      etsum_endc_[i] += other.etsum_endc_[i];
+      nhits_endc_[i] += other.nhits_endc_[i];
+      status_endc_[i] = std::max(status_endc_[i], other.status_endc_[i]);
+      et2sum_endc_[i] += other.et2sum_endc_[i];
+    }
+    nevents_ += other.nevents_;
+    return true;
+  }
+
+  std::vector<float>         etsum_barl_;
+  std::vector<unsigned int>  nhits_barl_;
+  std::vector<unsigned char> status_barl_;
+  std::vector<float>         et2sum_barl_;
+
+  std::vector<float>         etsum_endc_;
+  std::vector<unsigned int>  nhits_endc_;
+  std::vector<unsigned char> status_endc_;
+  std::vector<float>         et2sum_endc_;
+
+  /// events with a selected hit
+  unsigned int nevents_;
+
+};
+
+
+#endif
@@ -0,0 +1,9 @@
+#include "DataFormats/Common/interface/Wrapper.h"
+#include "PhiSym/EcalCalibDataFormats/interface/EcalPhiSymLumiSums.h"
+
+namespace PhiSym_EcalCalibDataFormats {
+  struct dictionary {
+    EcalPhiSymLumiSums lumiSums;
+    edm::Wrapper<EcalPhiSymLumiSums> wLumiSums;
+  };
+}